@@ -51,6 +51,9 @@ class OpenFile {
 		return numWritten;
 		}
 
+    void Seek(int position) { currentOffset = position; }
+    int Position() { return currentOffset; }
+
     int Length() { Lseek(file, 0, 2); return Tell(file); }
     
   private:
@@ -69,6 +72,8 @@ class OpenFile {
 
     void Seek(int position); 		// Set the position from which to 
 					// start reading/writing -- UNIX lseek
+    int Position() { return seekPosition; }
+					// ... and where it is now
 
     int Read(char *into, int numBytes); // Read/write bytes from the file,
 					// starting at the implicit position.
@@ -206,12 +206,27 @@ Interrupt::YieldOnReturn()
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	With user programs, the idle time is first put to use zeroing
+//	free page frames, so that later allocations don't have to.  Under
+//	VM, a process waiting on load control is let in rather than
+//	idling, since nothing else will make room for it.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
+#ifdef USER_PROGRAM
+    if (frameAllocator != NULL)
+	frameAllocator->ZeroFreeFrames(NumPhysPages);
+#endif
+#ifdef VM
+    if ((loadControl != NULL) && loadControl->ResumeIdle()) {
+	status = SystemMode;
+	return;				// there's now a runnable thread
+    }
+#endif
     if (CheckIfDue(TRUE)) {		// check for any pending interrupts
     	while (CheckIfDue(FALSE))	// check for any other pending 
 	    ;				// interrupts
@@ -18,6 +18,8 @@ static char* exceptionNames[] = { "no exception", "syscall",
 				"bus error", "address error", "overflow",
 				"illegal instruction" };
 
+int PageSize = SectorSize;		// see machine.h
+
 //----------------------------------------------------------------------
 // CheckEndian
 // 	Check to be sure that the host really uses the format it says it 
@@ -63,8 +65,10 @@ Machine::Machine(bool debug)
       	mainMemory[i] = 0;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
+    for (i = 0; i < TLBSize; i++) {
 	tlb[i].valid = FALSE;
+	tlb[i].numPages = 1;
+    }
     KernelPageTable = NULL;
 #else	// use linear page table
     tlb = NULL;
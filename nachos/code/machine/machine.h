@@ -28,12 +28,13 @@
 
 // Definitions related to the size, and format of user memory
 
-#define PageSize 	SectorSize 	// set the page size equal to
-					// the disk sector size, for
-					// simplicity
+extern int PageSize;			// bytes per page: a power of two,
+					// and a whole number of disk
+					// sectors; SectorSize unless set
+					// with -pagesize
 
-#define NumPhysPages    32
-#define MemorySize 	(NumPhysPages * PageSize)
+#define MemorySize 	(32 * SectorSize)	// bytes of physical memory
+#define NumPhysPages    (MemorySize / PageSize)
 #define TLBSize		4		// if there is a TLB, make it small
 
 enum ExceptionType { NoException,           // Everything ok!
@@ -22,6 +22,13 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageIns = numPageOuts = numFaultAroundPages = 0;
+    numLoadSuspensions = numLoadDelays = 0;
+    numPagesMerged = numMergeFramesSaved = peakMergeFramesSaved = 0;
+    numSwapCacheHits = numSwapCacheMisses = numSwapCacheSpills = 0;
+    numSwapCacheBytesIn = numSwapCacheBytesStored = 0;
+    numCheckpoints = numCheckpointPages = 0;
+    numDispatches = numVoluntarySwitches = numInvoluntarySwitches = 0;
 }
 
 //----------------------------------------------------------------------
@@ -38,7 +45,89 @@ Statistics::Print()
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, page ins %d, page outs %d\n", numPageFaults,
+	numPageIns, numPageOuts);
+    if (numFaultAroundPages > 0)
+	printf("Fault-around: pages %d\n", numFaultAroundPages);
+    if ((numLoadSuspensions > 0) || (numLoadDelays > 0))
+	printf("Load control: suspensions %d, delayed admissions %d\n",
+	    numLoadSuspensions, numLoadDelays);
+    if (numPagesMerged > 0)
+	printf("Page merging: pages merged %d, frames saved %d (peak %d)\n",
+	    numPagesMerged, numMergeFramesSaved, peakMergeFramesSaved);
+    if (numSwapCacheBytesIn > 0)
+	printf("Swap cache: hits %d, misses %d (%d%% hit), spills %d, "
+	    "%d bytes stored in %d (%d%%)\n", numSwapCacheHits,
+	    numSwapCacheMisses,
+	    (numSwapCacheHits * 100) / max(numSwapCacheHits
+					   + numSwapCacheMisses, 1),
+	    numSwapCacheSpills, numSwapCacheBytesIn, numSwapCacheBytesStored,
+	    (int) ((numSwapCacheBytesStored * 100.0) / numSwapCacheBytesIn));
+    if (numCheckpoints > 0)
+	printf("Checkpoints: %d, pages written %d\n", numCheckpoints,
+	    numCheckpointPages);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    printf("Scheduler: dispatches %d (%d per 1000 ticks), voluntary %d, "
+	"involuntary %d\n", numDispatches,
+	totalTicks > 0 ? (int) ((numDispatches * 1000.0) / totalTicks) : 0,
+	numVoluntarySwitches, numInvoluntarySwitches);
+    readyWaitTicks.Print("Ready queue wait");
+    runTicks.Print("Run length");
+    sleepLatency.Print("Sleep wakeup latency");
+}
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize a histogram with no samples.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    count = total = maxValue = 0;
+    for (int i = 0; i < NumHistBuckets; i++)
+	buckets[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Record
+// 	Add "value" (in ticks) to the bucket covering it.
+//----------------------------------------------------------------------
+
+void
+Histogram::Record(int value)
+{
+    int i = 0;
+
+    if (value < 0)
+	value = 0;
+    while (i < NumHistBuckets - 1 && value >= (1 << i))
+	i++;
+    buckets[i]++;
+    count++;
+    total += value;
+    if (value > maxValue)
+	maxValue = value;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print a summary line, then one line per non-empty bucket.
+//----------------------------------------------------------------------
+
+void
+Histogram::Print(char *title)
+{
+    printf("%s: samples %d, average %d, max %d\n", title, count,
+	count > 0 ? total / count : 0, maxValue);
+    for (int i = 0; i < NumHistBuckets; i++) {
+	if (buckets[i] == 0)
+	    continue;
+	if (i == 0)
+	    printf("\t0\t\t%d\n", buckets[i]);
+	else if (i == NumHistBuckets - 1)
+	    printf("\t>= %d\t%d\n", 1 << (i - 1), buckets[i]);
+	else
+	    printf("\t%d-%d\t\t%d\n", 1 << (i - 1), (1 << i) - 1, buckets[i]);
+    }
 }
@@ -13,6 +13,26 @@
 
 #include "copyright.h"
 
+// The following class defines a histogram of non-negative tick counts,
+// with power-of-two buckets: bucket 0 counts values of 0, bucket i
+// counts values in [2^(i-1), 2^i), and the last bucket counts everything
+// larger.
+
+#define NumHistBuckets	16
+
+class Histogram {
+  public:
+    Histogram();		// initialize all buckets to zero
+
+    void Record(int value);	// add one sample
+    void Print(char *title);	// print the non-empty buckets
+
+    int count;			// number of samples
+    int total;			// sum of all samples
+    int maxValue;		// largest sample seen
+    int buckets[NumHistBuckets];
+};
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -33,9 +53,35 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numPageIns;		// number of page faults satisfied from swap
+    int numPageOuts;		// number of dirty pages written on eviction
+    int numFaultAroundPages;	// pages brought in next to a faulting one
+    int numLoadSuspensions;	// processes suspended by load control
+    int numLoadDelays;		// processes kept waiting to be admitted
+    int numPagesMerged;		// pages remapped to an identical frame
+    int numMergeFramesSaved;	// frames saved by merging, at the last
+				// scan
+    int peakMergeFramesSaved;	// ... and at most
+    int numSwapCacheHits;	// swap reads served by the compressed pool
+    int numSwapCacheMisses;	// swap reads that went to disk
+    int numSwapCacheSpills;	// pages written from the pool to disk
+    int numSwapCacheBytesIn;	// bytes of pages put in the pool
+    int numSwapCacheBytesStored;	// ... and what they compressed to
+    int numCheckpoints;		// process checkpoints taken
+    int numCheckpointPages;	// pages written to them
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    int numDispatches;		// number of context switches
+    int numVoluntarySwitches;	// switches because a thread yielded,
+				// blocked or finished
+    int numInvoluntarySwitches;	// switches because of a timer preemption
+    Histogram readyWaitTicks;	// time from being put on the ready list
+				// to being scheduled
+    Histogram runTicks;		// time run before giving up the CPU
+    Histogram sleepLatency;	// how late sleeping threads got the
+				// CPU back, after their wake-up time
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
@@ -221,7 +221,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	entry = &KernelPageTable[vpn];
     } else {
         for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
+    	    if (tlb[i].valid && (vpn - (unsigned) tlb[i].virtualPage
+				 < (unsigned) tlb[i].numPages)) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
@@ -237,11 +238,11 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	DEBUG('a', "%d mapped read-only at %d in TLB!\n", virtAddr, i);
 	return ReadOnlyException;
     }
-    pageFrame = entry->physicalPage;
+    pageFrame = entry->physicalPage + (vpn - entry->virtualPage);
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) NumPhysPages) { 
 	DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
 	return BusErrorException;
     }
@@ -23,7 +23,9 @@
 
 // The following class defines an entry in a translation table -- either
 // in a page table or a TLB.  Each entry defines a mapping from one 
-// virtual page to one physical page.
+// virtual page to one physical page.  A TLB entry can also map a large
+// page: "numPages" contiguous virtual pages, starting at "virtualPage",
+// onto as many contiguous physical pages.
 // In addition, there are some extra bits for access control (valid and 
 // read-only) and some bits for usage information (use and dirty).
 
@@ -32,6 +34,7 @@ class TranslationEntry {
     int virtualPage;  	// The page number in virtual memory.
     int physicalPage;  	// The page number in real memory (relative to the
 			//  start of "mainMemory"
+    int numPages;	// Pages mapped; always 1 in a page table
     bool valid;         // If this bit is set, the translation is ignored.
 			// (In other words, the entry hasn't been initialized.)
     bool readOnly;	// If this bit is set, the user program is not allowed
@@ -0,0 +1,48 @@
+/* checkpoint.c
+ *	A long-running job that checkpoints itself after each round of
+ *	work.  Part way through, it halts Nachos as if it had crashed;
+ *	"nachos -restore checkpoint.ckpt" then carries on from the last
+ *	checkpoint and finishes the job.  Each round only writes to a few
+ *	pages of the array, so only those are saved again.
+ */
+
+#include "syscall.h"
+
+#define ArraySize	4096
+#define NumRounds	8
+#define CrashRound	4
+
+int array[ArraySize];
+int round;
+
+int
+main()
+{
+    int i, sum, status;
+
+    for (; round < NumRounds; round++) {
+	for (i = round * 32; i < round * 32 + 256; i++)
+	    array[i] += round;
+	status = syscall_wrapper_Checkpoint("checkpoint.ckpt");
+	if (status == 1) {
+	    syscall_wrapper_PrintString("Resumed after round ");
+	    syscall_wrapper_PrintInt(round);
+	    syscall_wrapper_PrintChar('\n');
+	} else if (status == -1) {
+	    syscall_wrapper_PrintString("Checkpoint failed\n");
+	    syscall_wrapper_Exit(1);
+	} else if (round == CrashRound) {
+	    syscall_wrapper_PrintString("Crashing after round ");
+	    syscall_wrapper_PrintInt(round);
+	    syscall_wrapper_PrintChar('\n');
+	    syscall_wrapper_Halt();
+	}
+    }
+    for (sum = 0, i = 0; i < ArraySize; i++)
+	sum += array[i];
+    syscall_wrapper_PrintString("Sum ");
+    syscall_wrapper_PrintInt(sum);
+    syscall_wrapper_PrintChar('\n');
+    syscall_wrapper_Exit(0);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/* memstats.c
+ *	Print the memory usage the kernel has recorded for this process,
+ *	before and after touching a large array.
+ */
+
+#include "syscall.h"
+
+#define ArraySize	4096
+
+int stats[MemStatSize];
+int array[ArraySize];
+
+void
+PrintMemStats (char *title)
+{
+    syscall_wrapper_GetMemStats(stats, MemStatSize);
+    syscall_wrapper_PrintString(title);
+    syscall_wrapper_PrintString(": virtual ");
+    syscall_wrapper_PrintInt(stats[MemStat_VirtualPages]);
+    syscall_wrapper_PrintString(" pages, resident ");
+    syscall_wrapper_PrintInt(stats[MemStat_ResidentPages]);
+    syscall_wrapper_PrintString(" (peak ");
+    syscall_wrapper_PrintInt(stats[MemStat_PeakResident]);
+    syscall_wrapper_PrintString("), swap ");
+    syscall_wrapper_PrintInt(stats[MemStat_SwapPages]);
+    syscall_wrapper_PrintString(", faults ");
+    syscall_wrapper_PrintInt(stats[MemStat_PageFaults]);
+    syscall_wrapper_PrintString(", page ins ");
+    syscall_wrapper_PrintInt(stats[MemStat_PageIns]);
+    syscall_wrapper_PrintString(", page outs ");
+    syscall_wrapper_PrintInt(stats[MemStat_PageOuts]);
+    syscall_wrapper_PrintChar('\n');
+}
+
+int
+main()
+{
+    int i;
+
+    PrintMemStats("At start");
+    for (i = 0; i < ArraySize; i++)
+	array[i] = i;
+    PrintMemStats("After filling the array");
+    syscall_wrapper_Exit(0);
+    return 0;
+}
@@ -0,0 +1,40 @@
+/* mmap.c
+ *	Test program for memory-mapped files.
+ *
+ *	Write a file, map it, change every byte through the mapping, unmap
+ *	it, and read the file back to check the changes were written out.
+ */
+
+#include "syscall.h"
+
+#define SIZE	300
+
+int
+main()
+{
+    OpenFileId fd;
+    char buf[SIZE];
+    char *p;
+    int i, errors = 0;
+
+    for (i = 0; i < SIZE; i++) buf[i] = 'a' + (i % 26);
+    syscall_wrapper_Create("mmapfile");
+    fd = syscall_wrapper_Open("mmapfile");
+    syscall_wrapper_Write(buf, SIZE, fd);
+
+    p = syscall_wrapper_Mmap(fd, SIZE);
+    syscall_wrapper_Close(fd);		/* the mapping stays */
+    for (i = 0; i < SIZE; i++) p[i] = p[i] - 'a' + 'A';
+    syscall_wrapper_Munmap(p);
+
+    fd = syscall_wrapper_Open("mmapfile");
+    syscall_wrapper_Read(buf, SIZE, fd);
+    syscall_wrapper_Close(fd);
+    for (i = 0; i < SIZE; i++)
+       if (buf[i] != 'A' + (i % 26)) errors++;
+
+    syscall_wrapper_PrintString("Mismatched bytes: ");
+    syscall_wrapper_PrintInt(errors);
+    syscall_wrapper_PrintChar('\n');
+    return 0;
+}
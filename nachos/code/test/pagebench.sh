@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# pagebench.sh
+#	Page replacement benchmarks.  Run each program under the vm
+#	kernel for every combination of replacement policy and amount
+#	of physical memory, and print one CSV line per run, taken from
+#	the statistics Nachos prints when it halts.  A run in which Nachos
+#	crashes, or kills the program for want of memory, is marked
+#	"failed" in place of its statistics, and the rest are left empty.
+#
+#	Run from the test directory, after building ../vm and the test
+#	programs ("make pagebench" does both of the latter):
+#
+#		sh pagebench.sh > pagebench.csv
+#
+#	The lists can be overridden from the environment, e.g.
+#
+#		POLICIES="fifo clock" FRAMES="8 16" sh pagebench.sh
+
+NACHOS=${NACHOS:-../vm/nachos}
+PROGRAMS=${PROGRAMS:-"matmult sort vectorsum pagemix"}
+POLICIES=${POLICIES:-"fifo random clock ws"}
+FRAMES=${FRAMES:-"8 12 16 24 32"}
+SEED=${SEED:-1}
+OUT=${TMPDIR:-/tmp}/pagebench.$$
+
+echo "program,policy,frames,total_ticks,page_faults,page_ins,page_outs,disk_reads,disk_writes"
+for program in $PROGRAMS; do
+    for policy in $POLICIES; do
+	for frames in $FRAMES; do
+	    rm -f SWAP
+	    prefix="$program,$policy,$frames"
+	    if $NACHOS -rs $SEED -vmpolicy $policy -mem $frames \
+		    -x ../test/$program > $OUT 2>&1 \
+		    && grep -q "^Ticks:" $OUT \
+		    && ! grep -q "^Out of memory" $OUT; then
+		awk -v prefix="$prefix" '
+		/^Ticks:/	{ ticks = $3 }
+		/^Disk I\/O:/	{ reads = $4; writes = $6 }
+		/^Paging:/	{ faults = $3; ins = $6; outs = $9 }
+		END { gsub(",", "", ticks); gsub(",", "", reads);
+		      gsub(",", "", faults); gsub(",", "", ins);
+		      printf "%s,%s,%s,%s,%s,%s,%s\n", prefix, ticks,
+			faults, ins, outs, reads, writes }' $OUT
+	    else
+		echo "$prefix,failed,,,,,"
+	    fi
+	done
+    done
+done
+rm -f SWAP $OUT
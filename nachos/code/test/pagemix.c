@@ -0,0 +1,18 @@
+/* pagemix.c
+ *	Concurrent mix for the page replacement benchmarks: run matmult,
+ *	sort and vectorsum side by side, so that they compete for
+ *	physical memory.  See pagebench.sh.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    if (syscall_wrapper_Fork() == 0)
+	syscall_wrapper_Exec("../test/matmult");
+    if (syscall_wrapper_Fork() == 0)
+	syscall_wrapper_Exec("../test/sort");
+    syscall_wrapper_Exec("../test/vectorsum");
+    return 0;
+}
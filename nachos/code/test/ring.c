@@ -0,0 +1,76 @@
+/* ring.c
+ *	System call ring library; see ring.h.
+ */
+
+#include "ring.h"
+
+int
+RingInit(SyscallRing *ring)
+{
+    return syscall_wrapper_RingSetup(ring);
+}
+
+int
+RingSubmit(SyscallRing *ring, int code, int arg1, int arg2, int arg3,
+	   int tag)
+{
+    SyscallRingRequest *request;
+
+    if (ring->submitTail - ring->submitHead >= SyscallRingSize)
+	syscall_wrapper_RingEnter();
+    if (ring->submitTail - ring->submitHead >= SyscallRingSize)
+	return -1;
+    request = &ring->requests[ring->submitTail & (SyscallRingSize - 1)];
+    request->code = code;
+    request->arg1 = arg1;
+    request->arg2 = arg2;
+    request->arg3 = arg3;
+    request->tag = tag;
+    ring->submitTail++;		/* only now can the kernel see it */
+    return 0;
+}
+
+int
+RingWrite(SyscallRing *ring, char *buffer, int size, OpenFileId id, int tag)
+{
+    return RingSubmit(ring, SysCall_Write, (int) buffer, size, id, tag);
+}
+
+int
+RingRead(SyscallRing *ring, char *buffer, int size, OpenFileId id, int tag)
+{
+    return RingSubmit(ring, SysCall_Read, (int) buffer, size, id, tag);
+}
+
+int
+RingYield(SyscallRing *ring, int tag)
+{
+    return RingSubmit(ring, SysCall_Yield, 0, 0, 0, tag);
+}
+
+int
+RingSleep(SyscallRing *ring, int ticks, int tag)
+{
+    return RingSubmit(ring, SysCall_Sleep, ticks, 0, 0, tag);
+}
+
+int
+RingFlush(SyscallRing *ring)
+{
+    return syscall_wrapper_RingEnter();
+}
+
+int
+RingReap(SyscallRing *ring, int *tag, int *result)
+{
+    SyscallRingCompletion *completion;
+
+    if (ring->completionHead == ring->completionTail)
+	return 0;
+    completion =
+	&ring->completions[ring->completionHead & (SyscallRingSize - 1)];
+    *tag = completion->tag;
+    *result = completion->result;
+    ring->completionHead++;
+    return 1;
+}
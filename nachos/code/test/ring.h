@@ -0,0 +1,40 @@
+/* ring.h
+ *	A small library for queueing system calls in a system call ring
+ *	(see RingSetup in syscall.h), so that a batch of them costs one
+ *	trap into the kernel.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include "syscall.h"
+
+/* Register "ring" with the kernel.  Returns 0, or -1 on failure. */
+int RingInit(SyscallRing *ring);
+
+/* Queue a system call.  If the ring is full, the kernel is entered to
+ * make room.  Returns 0, or -1 if there is still no room because
+ * nobody has reaped the completions.
+ */
+int RingSubmit(SyscallRing *ring, int code, int arg1, int arg2, int arg3,
+	       int tag);
+
+/* Queue a Write, Read, Yield or Sleep. */
+int RingWrite(SyscallRing *ring, char *buffer, int size, OpenFileId id,
+	      int tag);
+int RingRead(SyscallRing *ring, char *buffer, int size, OpenFileId id,
+	     int tag);
+int RingYield(SyscallRing *ring, int tag);
+int RingSleep(SyscallRing *ring, int ticks, int tag);
+
+/* Have the kernel carry out everything queued so far.  Returns how many
+ * requests it carried out.
+ */
+int RingFlush(SyscallRing *ring);
+
+/* Take the oldest completion, if there is one: store its tag and result
+ * and return 1.  Returns 0 if there is nothing to take.
+ */
+int RingReap(SyscallRing *ring, int *tag, int *result);
+
+#endif /* RING_H */
@@ -0,0 +1,40 @@
+/* ringtest.c
+ *	Test program for the system call ring: queue up a batch of console
+ *	writes, have them carried out with a single trap, and check that
+ *	a completion comes back for each, in order.
+ */
+
+#include "ring.h"
+
+#define NUM_LINES	10
+
+SyscallRing ring;
+char line[] = "line 0 written through the ring\n";
+
+int
+main()
+{
+    int i, tag, result, done, errors = 0;
+
+    if (RingInit(&ring) != 0) {
+	syscall_wrapper_PrintString("RingSetup failed\n");
+	syscall_wrapper_Exit(1);
+    }
+    for (i = 0; i < NUM_LINES; i++)
+	RingWrite(&ring, line, sizeof(line) - 1, ConsoleOutput, i);
+    done = RingFlush(&ring);
+
+    for (i = 0; RingReap(&ring, &tag, &result); i++)
+	if ((tag != i) || (result != sizeof(line) - 1))
+	    errors++;
+    if ((done != NUM_LINES) || (i != NUM_LINES))
+	errors++;
+
+    syscall_wrapper_PrintString("Ring requests carried out: ");
+    syscall_wrapper_PrintInt(done);
+    syscall_wrapper_PrintString(", errors: ");
+    syscall_wrapper_PrintInt(errors);
+    syscall_wrapper_PrintChar('\n');
+    syscall_wrapper_Exit(errors);
+    return 0;
+}
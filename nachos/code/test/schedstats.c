@@ -0,0 +1,49 @@
+/* schedstats.c
+ *	Print the scheduler statistics collected by the kernel, after
+ *	running long enough to be preempted a few times.
+ */
+
+#include "syscall.h"
+
+int stats[SchedStatSize];
+
+void
+PrintHistogram (char *title, int first)
+{
+    int i;
+
+    syscall_wrapper_PrintString(title);
+    for (i = 0; i < SchedStatBuckets; i++) {
+       syscall_wrapper_PrintChar(' ');
+       syscall_wrapper_PrintInt(stats[first + i]);
+    }
+    syscall_wrapper_PrintChar('\n');
+}
+
+int
+main()
+{
+    int i, sum = 0;
+
+    for (i=0; i<1000; i++) sum += i;
+
+    syscall_wrapper_SchedStats(stats, SchedStatSize);
+    syscall_wrapper_PrintString("Dispatches: ");
+    syscall_wrapper_PrintInt(stats[SchedStat_Dispatches]);
+    syscall_wrapper_PrintString(" in ");
+    syscall_wrapper_PrintInt(stats[SchedStat_TotalTicks]);
+    syscall_wrapper_PrintString(" ticks, voluntary ");
+    syscall_wrapper_PrintInt(stats[SchedStat_Voluntary]);
+    syscall_wrapper_PrintString(", involuntary ");
+    syscall_wrapper_PrintInt(stats[SchedStat_Involuntary]);
+    syscall_wrapper_PrintChar('\n');
+    syscall_wrapper_PrintString("This thread waited ");
+    syscall_wrapper_PrintInt(stats[SchedStat_MyWaitTicks]);
+    syscall_wrapper_PrintString(" ticks and ran ");
+    syscall_wrapper_PrintInt(stats[SchedStat_MyRunTicks]);
+    syscall_wrapper_PrintString(" ticks\n");
+    PrintHistogram("Ready queue wait:", SchedStat_WaitHistogram);
+    PrintHistogram("Run length:", SchedStat_RunHistogram);
+    syscall_wrapper_Halt();
+    return sum;
+}
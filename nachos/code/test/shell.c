@@ -6,7 +6,7 @@ main()
     SpaceId newProc;
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
-    char prompt[2], ch, buffer[60];
+    char prompt[2], buffer[60];
     int i;
 
     prompt[0] = '-';
@@ -16,20 +16,17 @@ main()
     {
 	syscall_wrapper_Write(prompt, 2, output);
 
-	i = 0;
-	
-	do {
-	
-	    syscall_wrapper_Read(&buffer[i], 1, input); 
+	i = syscall_wrapper_Read(buffer, 59, input);	/* a whole line */
+	if( i <= 0 ) break;				/* end of file */
 
-	} while( buffer[i++] != '\n' );
-
-	buffer[--i] = '\0';
+	if( buffer[i-1] == '\n' ) i--;
+	buffer[i] = '\0';
 
 	/*if( i > 0 ) {
 		newProc = system_Exec(buffer);
 		system_Join(newProc);
 	}*/
     }
+    syscall_wrapper_Halt();
 }
 
@@ -218,6 +218,70 @@ syscall_wrapper_PrintIntHex:
 	j	$31
 	.end syscall_wrapper_PrintIntHex
 
+	.globl syscall_wrapper_SchedStats
+	.ent    syscall_wrapper_SchedStats
+syscall_wrapper_SchedStats:
+	addiu $2,$0,SysCall_SchedStats
+	syscall
+	j	$31
+	.end syscall_wrapper_SchedStats
+
+	.globl syscall_wrapper_Mmap
+	.ent    syscall_wrapper_Mmap
+syscall_wrapper_Mmap:
+	addiu $2,$0,SysCall_Mmap
+	syscall
+	j	$31
+	.end syscall_wrapper_Mmap
+
+	.globl syscall_wrapper_Munmap
+	.ent    syscall_wrapper_Munmap
+syscall_wrapper_Munmap:
+	addiu $2,$0,SysCall_Munmap
+	syscall
+	j	$31
+	.end syscall_wrapper_Munmap
+
+	.globl syscall_wrapper_RingSetup
+	.ent    syscall_wrapper_RingSetup
+syscall_wrapper_RingSetup:
+	addiu $2,$0,SysCall_RingSetup
+	syscall
+	j	$31
+	.end syscall_wrapper_RingSetup
+
+	.globl syscall_wrapper_RingEnter
+	.ent    syscall_wrapper_RingEnter
+syscall_wrapper_RingEnter:
+	addiu $2,$0,SysCall_RingEnter
+	syscall
+	j	$31
+	.end syscall_wrapper_RingEnter
+
+	.globl syscall_wrapper_GetMemStats
+	.ent    syscall_wrapper_GetMemStats
+syscall_wrapper_GetMemStats:
+	addiu $2,$0,SysCall_GetMemStats
+	syscall
+	j	$31
+	.end syscall_wrapper_GetMemStats
+
+	.globl syscall_wrapper_Checkpoint
+	.ent    syscall_wrapper_Checkpoint
+syscall_wrapper_Checkpoint:
+	addiu $2,$0,SysCall_Checkpoint
+	syscall
+	j	$31
+	.end syscall_wrapper_Checkpoint
+
+	.globl syscall_wrapper_Restore
+	.ent    syscall_wrapper_Restore
+syscall_wrapper_Restore:
+	addiu $2,$0,SysCall_Restore
+	syscall
+	j	$31
+	.end syscall_wrapper_Restore
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
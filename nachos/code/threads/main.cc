@@ -8,8 +8,13 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sb
+//		-s -x <nachos file> -restore <nachos file>
+//		-c <consoleIn> <consoleOut>
+//		-pagesize <bytes> -faultaround <pages>
+//		-vmpolicy <fifo|random|clock|ws> -mem <number of frames>
+//		-largepages <pages>
+//		-loadcontrol -merge -swapcache <bytes>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -20,10 +25,33 @@
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //
+//  THREADS
+//    -sb runs the synchronization microbenchmarks
+//
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -restore carries on running a user program from a checkpoint it
+//	took with the Checkpoint system call
 //    -c tests the console
+//    -pagesize sets the page size (default the disk sector size)
+//    -faultaround lets a page fault in a run of sequential faults bring
+//	in up to the given number of following pages as well
+//
+//  VM
+//    -vmpolicy chooses the page replacement policy (default fifo)
+//    -mem limits user programs to the given number of physical frames
+//    -largepages maps code and data in large pages of the given number
+//	of pages, where memory allows.  A large page saves TLB entries
+//	and nothing else, so this needs a TLB (USE_TLB, as in the vm
+//	build); other builds reject it
+//    -loadcontrol suspends processes, or delays starting them, while
+//	their working sets don't all fit in memory
+//    -merge runs a kernel thread that finds user pages with the same
+//	contents, and merges them into one frame, copy-on-write
+//    -swapcache keeps evicted pages compressed in a pool of the given
+//	number of bytes, and only writes them to the swap disk once the
+//	pool is full
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -56,9 +84,10 @@
 
 // External functions used by this file
 
-extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
+extern void ThreadTest(void), SynchBenchmark(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void LaunchUserProcess(char *file), ConsoleTest(char *in, char *out);
+extern void RestoreUserProcess(char *file);
 extern void MailTest(int networkID);
 
 //----------------------------------------------------------------------
@@ -92,11 +121,19 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+#ifdef THREADS
+        if (!strcmp(*argv, "-sb"))              // synch microbenchmarks
+            SynchBenchmark();
+#endif
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
             LaunchUserProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-restore")) {	// resume a user program
+	    ASSERT(argc > 1);
+            RestoreUserProcess(*(argv + 1));
+            argCount = 2;
         } else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
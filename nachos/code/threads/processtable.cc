@@ -0,0 +1,271 @@
+// processtable.cc 
+//	Routines to manage the table of pids.  See processtable.h.
+//
+//	Like the ready list, the table is touched with interrupts
+//	disabled, so that it is consistent however threads interleave.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "processtable.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize the table, with every pid from 1 to "tableSize" - 1
+//	free.
+//	Pid 0 is never handed out; it means "no process".
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable(int tableSize)
+{
+    int pid;
+
+    ASSERT(tableSize > 1);
+    size = tableSize;
+    table = new ProcessEntry[size];
+    freeHead = freeTail = 0;
+    for (pid = 1; pid < size; pid++)
+	Free(pid);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the table.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Allocate
+// 	Take the pid at the head of the free list for "thread", and make
+//	it a child of "ppid" (unless that is 0).
+//
+//	Returns the pid.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Allocate(NachOSThread *thread, int ppid)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ProcessEntry *entry;
+    int pid;
+
+    if (freeHead == 0)
+	Grow();
+    pid = freeHead;
+    entry = &table[pid];
+    freeHead = entry->nextFree;
+    if (freeHead == 0)
+	freeTail = 0;
+
+    entry->state = ProcessAlive;
+    entry->thread = thread;
+    entry->joinable = FALSE;
+    entry->exitStatus = 0;
+    entry->firstChild = 0;
+    entry->waitingFor = 0;
+    AddChild(ppid, pid);
+    (void) interrupt->SetLevel(oldLevel);
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::MakeJoinable
+// 	Note that "pid" runs a user program, so its parent may Join it.
+//	Other threads (the page merger, say, or the postal worker) are
+//	never joined, and would otherwise sit as zombies for as long as
+//	their parent lived.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::MakeJoinable(int pid)
+{
+    ASSERT(table[pid].state == ProcessAlive);
+    table[pid].joinable = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	Record that "pid" has finished, with exit status "status".  Its
+//	children are orphaned; those that have already finished are
+//	freed, since nobody can join them any more.  If it is joinable
+//	and its parent is still around, the entry stays as a zombie
+//	holding "status" until the parent joins it or finishes too, and
+//	the parent is woken if it is already waiting; otherwise the pid
+//	is freed straight away.
+//
+//	Called with interrupts disabled, by the finishing thread.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Exit(int pid, int status)
+{
+    ProcessEntry *entry = &table[pid];
+    ProcessEntry *parent;
+    int child, next;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    ASSERT(entry->state == ProcessAlive);
+    for (child = entry->firstChild; child != 0; child = next) {
+	next = table[child].nextSibling;
+	table[child].ppid = 0;
+	if (table[child].state == ProcessZombie)
+	    Free(child);
+    }
+    entry->firstChild = 0;
+
+    entry->thread = NULL;
+    entry->exitStatus = status;
+    if ((entry->ppid == 0) || !entry->joinable) {
+	RemoveChild(pid);
+	Free(pid);
+	return;
+    }
+    entry->state = ProcessZombie;
+    parent = &table[entry->ppid];
+    if (parent->waitingFor == pid) {
+	parent->waitingFor = 0;
+	scheduler->MoveThreadToReadyQueue(parent->thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait for "child", a child of "pid", to finish, and return its
+//	exit status.  Once joined, the child's pid is freed.
+//
+//	Returns -1 if "child" isn't a joinable child of "pid" (or has
+//	already been joined).
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Join(int pid, int child)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int status;
+
+    if ((child <= 0) || (child >= size) || (table[child].state == ProcessFree)
+		|| (table[child].ppid != pid) || !table[child].joinable) {
+	(void) interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+    if (table[child].state == ProcessAlive) {
+	table[pid].waitingFor = child;
+	table[pid].thread->PutThreadToSleep();	// woken by Exit
+    }
+    ASSERT(table[child].state == ProcessZombie);
+    status = table[child].exitStatus;
+    RemoveChild(child);
+    Free(child);
+    (void) interrupt->SetLevel(oldLevel);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Lookup, ProcessTable::GetParent
+// 	Find the thread with a given pid, or its parent's pid.
+//----------------------------------------------------------------------
+
+NachOSThread *
+ProcessTable::Lookup(int pid)
+{
+    if ((pid <= 0) || (pid >= size))
+	return NULL;
+    return table[pid].thread;
+}
+
+int
+ProcessTable::GetParent(int pid)
+{
+    if ((pid <= 0) || (pid >= size) || (table[pid].state == ProcessFree))
+	return 0;
+    return table[pid].ppid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Grow
+// 	Double the size of the table, putting the new pids on the free
+//	list.  Existing pids keep their entries.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Grow()
+{
+    ProcessEntry *oldTable = table;
+    int oldSize = size;
+    int pid;
+
+    size *= 2;
+    table = new ProcessEntry[size];
+    for (pid = 0; pid < oldSize; pid++)
+	table[pid] = oldTable[pid];
+    delete [] oldTable;
+    for (pid = oldSize; pid < size; pid++)
+	Free(pid);
+    DEBUG('t', "Process table grown to %d pids\n", size);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::AddChild, ProcessTable::RemoveChild
+// 	Link "pid" onto the front of the list of children of "ppid",
+//	or take it off its parent's list.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::AddChild(int ppid, int pid)
+{
+    ProcessEntry *entry = &table[pid];
+
+    entry->ppid = ppid;
+    entry->prevSibling = 0;
+    entry->nextSibling = 0;
+    if (ppid == 0)
+	return;
+    entry->nextSibling = table[ppid].firstChild;
+    if (entry->nextSibling != 0)
+	table[entry->nextSibling].prevSibling = pid;
+    table[ppid].firstChild = pid;
+}
+
+void
+ProcessTable::RemoveChild(int pid)
+{
+    ProcessEntry *entry = &table[pid];
+
+    if (entry->ppid == 0)
+	return;
+    if (entry->prevSibling != 0)
+	table[entry->prevSibling].nextSibling = entry->nextSibling;
+    else
+	table[entry->ppid].firstChild = entry->nextSibling;
+    if (entry->nextSibling != 0)
+	table[entry->nextSibling].prevSibling = entry->prevSibling;
+    entry->ppid = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Free
+// 	Put "pid" at the tail of the free list.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Free(int pid)
+{
+    ProcessEntry *entry = &table[pid];
+
+    entry->state = ProcessFree;
+    entry->thread = NULL;
+    entry->ppid = 0;
+    entry->nextFree = 0;
+    if (freeTail == 0)
+	freeHead = pid;
+    else
+	table[freeTail].nextFree = pid;
+    freeTail = pid;
+}
@@ -0,0 +1,78 @@
+// processtable.h 
+//	Data structures to find a thread by its pid, and to keep the
+//	parent/child relationships between threads that Join needs.
+//
+//	The table is an array indexed by pid, so every lookup is O(1).
+//	Free pids are kept on a FIFO list, so a pid is only reused once
+//	every other free pid has had its turn.  Each entry also links its
+//	thread into its parent's list of children, and keeps a finished
+//	thread's exit status (as a "zombie") until the parent joins it or
+//	exits itself.  Only user processes can be joined; kernel threads
+//	are freed as soon as they finish.  The array grows, by doubling,
+//	when all pids are in use.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCESSTABLE_H
+#define PROCESSTABLE_H
+
+#include "copyright.h"
+
+#define InitialProcessTableSize	64	// pids before the table first grows
+
+class NachOSThread;
+
+enum ProcessState { ProcessFree, ProcessAlive, ProcessZombie };
+
+// One pid's entry.  Pids are used as links; 0 means none.
+
+struct ProcessEntry {
+    ProcessState state;
+    NachOSThread *thread;		// The thread, while it is alive
+    int ppid;				// Parent, or 0 if it has none
+    bool joinable;			// A user process, kept as a zombie
+					// for its parent to Join
+    int exitStatus;			// Set when the thread finishes
+    int firstChild;			// Children not yet joined
+    int prevSibling, nextSibling;	// ... and the links between them
+    int waitingFor;			// Child this thread is joining
+    int nextFree;			// Next pid on the free list
+};
+
+// The following class defines the process table.
+
+class ProcessTable {
+  public:
+    ProcessTable(int tableSize);	// Initialize, with room for
+					// "tableSize" pids before it has
+					// to grow
+    ~ProcessTable();			// De-allocate the table
+
+    int Allocate(NachOSThread *thread, int ppid);
+					// Give "thread" a pid, as a child
+					// of "ppid"
+    void MakeJoinable(int pid);		// "pid" is a user process, which
+					// its parent may Join
+    void Exit(int pid, int status);	// "pid" has finished with "status";
+					// called with interrupts off
+    int Join(int pid, int child);	// Wait for "child" of "pid" to
+					// finish; returns its exit status,
+					// or -1 if it isn't a child
+
+    NachOSThread *Lookup(int pid);	// Thread with "pid", or NULL
+    int GetParent(int pid);		// Parent of "pid", or 0
+
+  private:
+    ProcessEntry *table;		// Indexed by pid; entry 0 unused
+    int size;				// Entries in the table
+    int freeHead, freeTail;		// Free list of pids
+
+    void Grow();			// Double the size of the table
+    void AddChild(int ppid, int pid);	// Link "pid" into "ppid"'s children
+    void RemoveChild(int pid);		// ... and unlink it
+    void Free(int pid);			// Put "pid" on the free list
+};
+
+#endif // PROCESSTABLE_H
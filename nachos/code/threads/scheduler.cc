@@ -30,6 +30,11 @@
 ProcessScheduler::ProcessScheduler()
 { 
     listOfReadyThreads = new List; 
+    preemptPending = FALSE;
+#ifdef USER_PROGRAM
+    userRegistersOwner = NULL;
+    activeSpace = NULL;
+#endif
 } 
 
 //----------------------------------------------------------------------
@@ -56,6 +61,7 @@ ProcessScheduler::MoveThreadToReadyQueue (NachOSThread *thread)
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
     thread->setStatus(READY);
+    thread->readySince = stats->totalTicks;
     listOfReadyThreads->Append((void *)thread);
 }
 
@@ -81,6 +87,14 @@ ProcessScheduler::SelectNextReadyThread ()
 //
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
+//
+//	Also accounts for the switch in the scheduling statistics: how
+//	long the old thread ran, how long the new one waited on the ready
+//	list, and whether the old thread gave up the CPU voluntarily.
+//
+//	User-level state is not saved here: it stays in the machine until
+//	another user thread needs it (see LoadUserRegisters), so switching
+//	to a kernel thread and back costs no register copies.
 // Side effect:
 //	The global variable currentThread becomes nextThread.
 //
@@ -91,13 +105,22 @@ void
 ProcessScheduler::ScheduleThread (NachOSThread *nextThread)
 {
     NachOSThread *oldThread = currentThread;
-    
-#ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveContextOnSwitch();
+    int now = stats->totalTicks;
+
+    stats->numDispatches++;
+    oldThread->runTicks += now - oldThread->runningSince;
+    stats->runTicks.Record(now - oldThread->runningSince);
+    if (preemptPending && oldThread->getStatus() == READY) {
+	oldThread->involuntarySwitches++;
+	stats->numInvoluntarySwitches++;
+    } else {
+	oldThread->voluntarySwitches++;
+	stats->numVoluntarySwitches++;
     }
-#endif
+    preemptPending = FALSE;
+    nextThread->waitTicks += now - nextThread->readySince;
+    stats->readyWaitTicks.Record(now - nextThread->readySince);
+    nextThread->runningSince = now;
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
@@ -128,12 +151,93 @@ ProcessScheduler::ScheduleThread (NachOSThread *nextThread)
     
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreContextOnSwitch();
+        LoadUserRegisters(currentThread);	// to restore, do it -- unless
+	ActivateAddressSpace(currentThread->space);	// it's still there
     }
 #endif
 }
 
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// ProcessScheduler::LoadUserRegisters
+// 	Make the user-level registers of "thread" the ones in the machine.
+//	If they still are (no other user thread ran since "thread" last
+//	did), there is nothing to copy.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::LoadUserRegisters (NachOSThread *thread)
+{
+    if (userRegistersOwner == thread)
+	return;
+    ClaimUserRegisters(thread);
+    thread->RestoreUserState();
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ClaimUserRegisters
+// 	Record that the machine registers are about to belong to "thread".
+//	The previous owner's registers are saved into its thread control
+//	block first, since it will need them back when it runs again.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ClaimUserRegisters (NachOSThread *thread)
+{
+    if (userRegistersOwner == thread)
+	return;
+    if (userRegistersOwner != NULL) {
+	DEBUG('t', "Saving user registers of \"%s\"\n",
+	      userRegistersOwner->getName());
+	userRegistersOwner->SaveUserState();
+    }
+    userRegistersOwner = thread;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ReleaseUserRegisters
+// 	"thread" is being deleted; if it owns the machine registers,
+//	there is nobody left to save them for.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ReleaseUserRegisters (NachOSThread *thread)
+{
+    if (userRegistersOwner == thread)
+	userRegistersOwner = NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ActivateAddressSpace
+// 	Load the translation for "space" into the machine, unless it is
+//	already loaded.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ActivateAddressSpace (ProcessAddressSpace *space)
+{
+    if (activeSpace == space)
+	return;
+    if (activeSpace != NULL)
+	activeSpace->SaveContextOnSwitch();
+    space->RestoreContextOnSwitch();
+    activeSpace = space;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::DeactivateAddressSpace
+// 	"space" is being deleted; make sure we don't think it is still
+//	loaded in the machine.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::DeactivateAddressSpace (ProcessAddressSpace *space)
+{
+    if (activeSpace == space)
+	activeSpace = NULL;
+}
+#endif
+
 //----------------------------------------------------------------------
 // ProcessScheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -27,10 +27,45 @@ class ProcessScheduler {
 					// list, if any, and return thread.
     void ScheduleThread (NachOSThread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+
+    void NotePreemption() { preemptPending = TRUE; }
+					// The next yield is a time-slice
+					// preemption, not a voluntary one
+    void CancelPreemption() { preemptPending = FALSE; }
+
+#ifdef USER_PROGRAM
+    // The machine's user registers and page table are switched lazily:
+    // they are only saved and reloaded when a *different* user context
+    // takes the CPU, not on every switch through a kernel-only thread.
+
+    void LoadUserRegisters(NachOSThread *thread);
+					// Make "thread"'s user registers live
+					// in the machine, if they aren't yet
+    void ClaimUserRegisters(NachOSThread *thread);
+					// Save the previous owner's registers,
+					// so "thread" can overwrite them
+    void ReleaseUserRegisters(NachOSThread *thread);
+					// "thread" is going away
+    void ActivateAddressSpace(ProcessAddressSpace *space);
+					// Load "space"'s page table, if it
+					// isn't loaded already
+    void DeactivateAddressSpace(ProcessAddressSpace *space);
+					// "space" is going away
+    ProcessAddressSpace *ActiveAddressSpace() { return activeSpace; }
+					// Whose translation is loaded
+#endif
     
   private:
     List *listOfReadyThreads;  		// queue of threads that are ready to run,
 				// but not running
+    bool preemptPending;		// set by the timer interrupt handler,
+					// cleared on the next context switch
+#ifdef USER_PROGRAM
+    NachOSThread *userRegistersOwner;	// thread whose user registers are
+					// in machine->registers, or NULL
+    ProcessAddressSpace *activeSpace;	// address space whose translation
+					// is loaded in the machine, or NULL
+#endif
 };
 
 #endif // SCHEDULER_H
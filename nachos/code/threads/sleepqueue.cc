@@ -0,0 +1,165 @@
+// sleepqueue.cc 
+//	Routines to put threads to sleep until a given time, and to wake
+//	them up from the timer interrupt handler.
+//
+//	The heap is only touched with interrupts disabled, since the
+//	timer interrupt handler takes threads off it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "sleepqueue.h"
+#include "system.h"
+
+#define InitialCapacity	16		// heap entries to start with
+
+//----------------------------------------------------------------------
+// SleepQueue::SleepQueue
+// 	Initialize an empty sleep queue.
+//----------------------------------------------------------------------
+
+SleepQueue::SleepQueue()
+{
+    capacity = InitialCapacity;
+    heap = new SleepEntry[capacity];
+    numEntries = 0;
+    nextSequence = 0;
+}
+
+//----------------------------------------------------------------------
+// SleepQueue::~SleepQueue
+// 	De-allocate the sleep queue.  Any threads still asleep are
+//	never woken.
+//----------------------------------------------------------------------
+
+SleepQueue::~SleepQueue()
+{
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// SleepQueue::Sleep
+// 	Put the current thread to sleep until at least "ticks" from now.
+//	It is woken by the first timer interrupt after that time, and
+//	then has to wait its turn on the ready queue, so it always runs
+//	again somewhat late.
+//
+//	Returns how late: the ticks between the wake-up time asked for
+//	and the time the thread got the CPU back.  This is also recorded
+//	in stats->sleepLatency.
+//----------------------------------------------------------------------
+
+int
+SleepQueue::Sleep(int ticks)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    SleepEntry *oldHeap;
+    int i, wakeTime, latency;
+
+    if (numEntries == capacity) {	// grow the heap
+	oldHeap = heap;
+	capacity *= 2;
+	heap = new SleepEntry[capacity];
+	for (i = 0; i < numEntries; i++)
+	    heap[i] = oldHeap[i];
+	delete [] oldHeap;
+    }
+    wakeTime = stats->totalTicks + ticks;
+    heap[numEntries].wakeTime = wakeTime;
+    heap[numEntries].sequence = nextSequence++;
+    heap[numEntries].thread = currentThread;
+    numEntries++;
+    SiftUp(numEntries - 1);
+
+    DEBUG('t', "Thread \"%s\" sleeping until %d\n", currentThread->getName(),
+	  wakeTime);
+    currentThread->PutThreadToSleep();
+
+    latency = stats->totalTicks - wakeTime;
+    stats->sleepLatency.Record(latency);
+    (void) interrupt->SetLevel(oldLevel);
+    return latency;
+}
+
+//----------------------------------------------------------------------
+// SleepQueue::WakeDue
+// 	Put every thread whose wake-up time has come on the ready queue.
+//	Called with interrupts disabled, from the timer interrupt handler.
+//----------------------------------------------------------------------
+
+void
+SleepQueue::WakeDue()
+{
+    NachOSThread *thread;
+
+    while ((numEntries > 0) && (heap[0].wakeTime <= stats->totalTicks)) {
+	thread = heap[0].thread;
+	numEntries--;
+	heap[0] = heap[numEntries];
+	SiftDown(0);
+	DEBUG('t', "Waking thread \"%s\"\n", thread->getName());
+	scheduler->MoveThreadToReadyQueue(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// SleepQueue::Before, SleepQueue::Swap
+// 	Compare and exchange heap entries "i" and "j".
+//----------------------------------------------------------------------
+
+bool
+SleepQueue::Before(int i, int j)
+{
+    if (heap[i].wakeTime != heap[j].wakeTime)
+	return heap[i].wakeTime < heap[j].wakeTime;
+    return heap[i].sequence < heap[j].sequence;
+}
+
+void
+SleepQueue::Swap(int i, int j)
+{
+    SleepEntry temp = heap[i];
+
+    heap[i] = heap[j];
+    heap[j] = temp;
+}
+
+//----------------------------------------------------------------------
+// SleepQueue::SiftUp, SleepQueue::SiftDown
+// 	Restore the heap order after entry "i" has been put in place,
+//	by moving it towards the root or towards the leaves.
+//----------------------------------------------------------------------
+
+void
+SleepQueue::SiftUp(int i)
+{
+    int parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (!Before(i, parent))
+	    break;
+	Swap(i, parent);
+	i = parent;
+    }
+}
+
+void
+SleepQueue::SiftDown(int i)
+{
+    int child;
+
+    for (;;) {
+	child = 2 * i + 1;
+	if (child >= numEntries)
+	    break;
+	if ((child + 1 < numEntries) && Before(child + 1, child))
+	    child++;
+	if (!Before(child, i))
+	    break;
+	Swap(i, child);
+	i = child;
+    }
+}
@@ -0,0 +1,56 @@
+// sleepqueue.h 
+//	Data structures for putting threads to sleep until a given time.
+//
+//	Sleeping threads are kept in a binary heap ordered by the time
+//	they are due to wake up, so going to sleep and being woken each
+//	cost O(log n) in the number of sleepers.  The queue is serviced
+//	from the timer interrupt handler, rather than scheduling a
+//	separate interrupt for every sleeper.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SLEEPQUEUE_H
+#define SLEEPQUEUE_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// One sleeping thread.  Threads due at the same time wake in the
+// order they went to sleep.
+
+struct SleepEntry {
+    int wakeTime;			// When to wake the thread
+    int sequence;			// Order among equal wake times
+    NachOSThread *thread;
+};
+
+// The following class defines the sleep queue.
+
+class SleepQueue {
+  public:
+    SleepQueue();			// Initialize, with nobody asleep
+    ~SleepQueue();			// De-allocate the queue
+
+    int Sleep(int ticks);		// Put the current thread to sleep
+					// for at least "ticks"; returns how
+					// many ticks late it woke up
+    void WakeDue();			// Move every thread that is due to
+					// the ready queue; called from the
+					// timer interrupt handler
+    int NumSleeping() { return numEntries; }
+
+  private:
+    SleepEntry *heap;			// heap[0] is due first
+    int numEntries;			// Threads in the heap
+    int capacity;			// Room in the heap
+    int nextSequence;			// For SleepEntry::sequence
+
+    bool Before(int i, int j);		// Is heap[i] due before heap[j]?
+    void Swap(int i, int j);
+    void SiftUp(int i);
+    void SiftDown(int i);
+};
+
+#endif // SLEEPQUEUE_H
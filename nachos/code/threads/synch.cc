@@ -1,8 +1,7 @@
 // synch.cc 
-//	Routines for synchronizing threads.  Three kinds of
-//	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//	Routines for synchronizing threads.  Five kinds of
+//	synchronization routines are defined here: semaphores, locks,
+//   	condition variables, reader-writer locks and barriers.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -97,16 +96,397 @@ Semaphore::V()
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-Lock::Lock(char* debugName) {}
-Lock::~Lock() {}
-void Lock::Acquire() {}
-void Lock::Release() {}
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for synchronization.
+//	The lock is initially FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Lock::Lock(char* debugName)
+{
+    name = debugName;
+    owner = NULL;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate lock, when no longer needed.  Assume no one
+//	is still waiting on the lock!
+//----------------------------------------------------------------------
+
+Lock::~Lock()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then set it to BUSY.  As with
+//	Semaphore::P(), checking and setting the owner must be atomic.
+//----------------------------------------------------------------------
+
+void
+Lock::Acquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-Condition::Condition(char* debugName) { }
-Condition::~Condition() { }
-void Condition::Wait(Lock* conditionLock) { ASSERT(FALSE); }
-void Condition::Signal(Lock* conditionLock) { }
-void Condition::Broadcast(Lock* conditionLock) { }
+    ASSERT(!isHeldByCurrentThread());		// locks are not recursive
+    while (owner != NULL) {			// lock is BUSY
+	queue->Append((void *)currentThread);	// so go to sleep
+	currentThread->PutThreadToSleep();
+    }
+    owner = currentThread;
+    DEBUG('s', "Lock \"%s\" acquired by \"%s\"\n", name,
+	  currentThread->getName());
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock to FREE, waking up a thread waiting in Acquire()
+//	if necessary.  Only the holder of the lock may release it.
+//----------------------------------------------------------------------
+
+void
+Lock::Release()
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(isHeldByCurrentThread());
+    owner = NULL;
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)		// let it retry the acquire
+	scheduler->MoveThreadToReadyQueue(thread);
+    DEBUG('s', "Lock \"%s\" released by \"%s\"\n", name,
+	  currentThread->getName());
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds this lock.
+//----------------------------------------------------------------------
+
+bool
+Lock::isHeldByCurrentThread()
+{
+    return owner == currentThread;
+}
+
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
+{
+    name = debugName;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate condition variable.  Assume no one is still waiting!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Atomically release "conditionLock" and go to sleep until
+//	signalled, then re-acquire the lock before returning.
+//
+//	Interrupts are turned off between queueing ourselves and
+//	going to sleep, so a Signal() can't slip in between.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    queue->Append((void *)currentThread);
+    conditionLock->Release();
+    currentThread->PutThreadToSleep();
+    conditionLock->Acquire();
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up one thread waiting on the condition, if any.  Mesa
+//	semantics: the woken thread has to re-acquire the lock itself.
+//----------------------------------------------------------------------
+
+void
+Condition::Signal(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->MoveThreadToReadyQueue(thread);
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up all threads waiting on the condition.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (NachOSThread *)queue->Remove()) != NULL)
+	scheduler->MoveThreadToReadyQueue(thread);
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, so that it can be used for
+//	synchronization.  The lock is initially FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"fair" -- if TRUE, readers that queued up behind a writer are
+//		admitted before the next writer.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName, bool isFair)
+{
+    name = debugName;
+    fair = isFair;
+    activeReaders = 0;
+    writer = NULL;
+    waitingReaders = waitingWriters = 0;
+    readQueue = new List;
+    writeQueue = new List;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	De-allocate the lock.  Assume no one holds it or is waiting on it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(activeReaders == 0 && writer == NULL);
+    delete readQueue;
+    delete writeQueue;
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadAcquire
+// 	Enter a read section.  We can get in right away unless a writer
+//	holds the lock, or (writer preference) a writer is waiting for it.
+//	Otherwise we sleep until a releasing thread admits us; by then
+//	activeReaders already counts us.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (writer == NULL && waitingWriters == 0)
+	activeReaders++;
+    else {
+	waitingReaders++;
+	readQueue->Append((void *)currentThread);
+	currentThread->PutThreadToSleep();	// admitted by WakeReaders
+    }
+    DEBUG('s', "RWLock \"%s\" read by \"%s\", %d readers\n", name,
+	  currentThread->getName(), activeReaders);
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadRelease
+// 	Leave a read section.  The last reader out hands the lock to
+//	the first waiting writer, if any.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(activeReaders > 0);
+    activeReaders--;
+    if (activeReaders == 0 && waitingWriters > 0)
+	WakeWriter();
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteAcquire
+// 	Enter the write section, waiting until there are no readers and
+//	no other writer.  As with readers, ownership is handed to us by
+//	whoever wakes us up.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(!isWriteHeldByCurrentThread());
+    if (writer == NULL && activeReaders == 0)
+	writer = currentThread;
+    else {
+	waitingWriters++;
+	writeQueue->Append((void *)currentThread);
+	currentThread->PutThreadToSleep();	// admitted by WakeWriter
+    }
+    ASSERT(writer == currentThread);
+    DEBUG('s', "RWLock \"%s\" written by \"%s\"\n", name,
+	  currentThread->getName());
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteRelease
+// 	Leave the write section.  Writers are preferred, so normally the
+//	next waiting writer gets the lock; if there is none, or if the
+//	lock is "fair" and readers are queued, all waiting readers are
+//	admitted together instead.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(isWriteHeldByCurrentThread());
+    writer = NULL;
+    if (waitingReaders > 0 && (fair || waitingWriters == 0))
+	WakeReaders();
+    else if (waitingWriters > 0)
+	WakeWriter();
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::isWriteHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock for writing.
+//----------------------------------------------------------------------
+
+bool
+RWLock::isWriteHeldByCurrentThread()
+{
+    return writer == currentThread;
+}
+
+//----------------------------------------------------------------------
+// RWLock::WakeReaders
+// 	Admit every queued reader at once.  Called with interrupts off
+//	and no writer holding the lock.
+//----------------------------------------------------------------------
+
+void
+RWLock::WakeReaders()
+{
+    NachOSThread *thread;
+
+    while ((thread = (NachOSThread *)readQueue->Remove()) != NULL) {
+	waitingReaders--;
+	activeReaders++;
+	scheduler->MoveThreadToReadyQueue(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::WakeWriter
+// 	Hand the lock to the first queued writer.  Called with interrupts
+//	off, no readers and no writer holding the lock.
+//----------------------------------------------------------------------
+
+void
+RWLock::WakeWriter()
+{
+    NachOSThread *thread = (NachOSThread *)writeQueue->Remove();
+
+    ASSERT(thread != NULL && activeReaders == 0);
+    waitingWriters--;
+    writer = thread;
+    scheduler->MoveThreadToReadyQueue(thread);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+// 	Initialize a barrier for "numThreads" participants.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(char* debugName, int participants)
+{
+    ASSERT(participants > 0);
+    name = debugName;
+    numThreads = participants;
+    arrived = 0;
+    phase = 0;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Barrier::~Barrier
+// 	De-allocate the barrier.  Assume no one is still waiting!
+//----------------------------------------------------------------------
+
+Barrier::~Barrier()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Barrier::Wait
+// 	Wait for all participants to arrive.  The last one to arrive
+//	wakes up everybody else and resets the barrier for the next phase.
+//----------------------------------------------------------------------
+
+void
+Barrier::Wait()
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    arrived++;
+    if (arrived < numThreads) {
+	queue->Append((void *)currentThread);
+	currentThread->PutThreadToSleep();
+    } else {
+	DEBUG('s', "Barrier \"%s\" opens, phase %d\n", name, phase);
+	arrived = 0;
+	phase++;
+	while ((thread = (NachOSThread *)queue->Remove()) != NULL)
+	    scheduler->MoveThreadToReadyQueue(thread);
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
+}
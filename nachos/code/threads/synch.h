@@ -1,11 +1,8 @@
 // synch.h 
 //	Data structures for synchronizing threads.
 //
-//	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	Five kinds of synchronization are defined here: semaphores,
+//	locks, condition variables, reader-writer locks and barriers.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -79,7 +76,8 @@ class Lock {
 
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
+    NachOSThread *owner;		// thread holding the lock, NULL if FREE
+    List *queue;			// threads waiting in Acquire()
 };
 
 // The following class defines a "condition variable".  A condition
@@ -131,6 +129,78 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Wait()
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold the lock at once, but a writer holds it exclusively.
+//
+//	ReadAcquire/ReadRelease -- enter/leave a shared (read) section
+//
+//	WriteAcquire/WriteRelease -- enter/leave an exclusive (write) section
+//
+// The lock is writer-preferring: once a writer is waiting, newly
+// arriving readers queue up behind it, so a steady stream of readers
+// cannot starve writers.  If "fair" is TRUE, a writer that releases the
+// lock first admits every reader that queued up while it was waiting
+// or writing, before the next writer gets in; that way a steady stream
+// of writers cannot starve readers either.
+//
+// Ownership is handed off directly to the threads that are woken up,
+// so a woken thread never has to re-check the lock state.
+
+class RWLock {
+  public:
+    RWLock(char* debugName, bool fair = FALSE);	// initialize lock to FREE
+    ~RWLock();					// deallocate lock
+    char* getName() { return name; }		// debugging assist
+
+    void ReadAcquire();		// wait until no writer holds or is
+				// waiting for the lock, then enter
+    void ReadRelease();		// leave, waking a writer if we are
+				// the last reader out
+    void WriteAcquire();	// wait until the lock is FREE, then
+				// hold it exclusively
+    void WriteRelease();	// leave, waking readers or a writer
+
+    bool isWriteHeldByCurrentThread();	// true if the current thread
+					// holds the lock for writing
+
+  private:
+    char* name;			// for debugging
+    bool fair;			// admit waiting readers before the
+				// next writer on WriteRelease
+    int activeReaders;		// number of threads in a read section
+    NachOSThread *writer;	// thread in the write section, or NULL
+    int waitingReaders;		// number of threads on readQueue
+    int waitingWriters;		// number of threads on writeQueue
+    List *readQueue;		// readers waiting in ReadAcquire()
+    List *writeQueue;		// writers waiting in WriteAcquire()
+
+    void WakeReaders();		// admit every waiting reader
+    void WakeWriter();		// admit the first waiting writer
+};
+
+// The following class defines a "barrier".  A barrier is created
+// for a fixed number of participating threads; each participant
+// calls Wait(), and nobody returns from Wait() until all of them
+// have called it.  The barrier then resets itself, so it can be
+// used again for the next phase of the computation.
+
+class Barrier {
+  public:
+    Barrier(char* debugName, int numThreads);	// set number of participants
+    ~Barrier();					// deallocate barrier
+    char* getName() { return name; }		// debugging assist
+
+    void Wait();		// block until all participants arrive
+
+  private:
+    char* name;			// for debugging
+    int numThreads;		// number of participants
+    int arrived;		// participants that have called Wait()
+				// in the current phase
+    int phase;			// incremented each time the barrier opens
+    List *queue;		// participants waiting in Wait()
 };
 #endif // SYNCH_H
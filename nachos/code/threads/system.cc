@@ -18,6 +18,9 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+SleepQueue *sleepQueue;			// threads waiting for a time,
+					// woken by the timer
+ProcessTable *processTable;		// threads by pid, for Join
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -29,13 +32,28 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+FrameAllocator *frameAllocator;	// free physical page frames
+TextPageCache *textPageCache;	// code pages shared between processes
+SynchConsole *synchConsole;	// terminal for console system calls
+int largePagePages = 1;		// pages per large page; 1 means
+				// large pages are off, as they always
+				// are without a TLB
+int faultAroundPages = 0;	// most pages to bring in after a
+				// faulting one; 0 means none
+Lock *pagingLock;		// serializes page faults
+#endif
+
+#ifdef VM
+CoreMap *coreMap;		// which page each frame holds
+SwapSpace *swapSpace;		// backing store for evicted pages
+LoadControl *loadControl;		// keeps working sets within memory
+PageMerger *pageMerger;			// merges identical pages
 #endif
 
 #ifdef NETWORK
 PostOffice *postOffice;
 #endif
 
-bool initializedConsoleSemaphores;
 
 // External definition, to allow us to take a pointer to this function
 extern void Cleanup();
@@ -55,14 +73,28 @@ extern void Cleanup();
 //	if the interrupted thread called YieldCPU at the point it is 
 //	was interrupted.
 //
+//	The scheduler is told that the coming yield is a preemption, so
+//	it can be counted as an involuntary context switch.
+//
+//	Sleeping threads whose time has come are woken here too, so that
+//	sleeping costs no interrupts of its own, and so are processes
+//	waiting on load control, if they now fit in memory.
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(int dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    sleepQueue->WakeDue();
+#ifdef VM
+    if (loadControl != NULL)
+	loadControl->Balance();
+#endif
+    if (interrupt->getStatus() != IdleMode) {
 	interrupt->YieldOnReturn();
+	scheduler->NotePreemption();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -82,11 +114,18 @@ Initialize(int argc, char **argv)
     char* debugArgs = "";
     bool randomYield = FALSE;
 
-    initializedConsoleSemaphores = false;
-
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
 #endif
+#ifdef VM
+    ReplacementPolicy policy = FIFOReplacement;	// page replacement
+    int numFrames = 0;			// physical memory for user pages,
+					// or 0 for all of it
+    bool useLoadControl = FALSE;	// suspend processes whose working
+					// sets don't fit
+    bool useMerging = FALSE;		// merge identical pages
+    int swapCacheBytes = 0;		// compressed swap pool, or 0
+#endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
 #endif
@@ -114,6 +153,52 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-pagesize")) {
+	    ASSERT(argc > 1);
+	    PageSize = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-largepages")) {
+	    ASSERT(argc > 1);
+#ifdef USE_TLB
+	    largePagePages = atoi(*(argv + 1));
+#else
+	    printf("-largepages needs a TLB\n");
+	    ASSERT(FALSE);		// only the TLB can map a large page
+#endif
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-faultaround")) {
+	    ASSERT(argc > 1);
+	    faultAroundPages = atoi(*(argv + 1));
+	    argCount = 2;
+	}
+#endif
+#ifdef VM
+	if (!strcmp(*argv, "-vmpolicy")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fifo"))
+		policy = FIFOReplacement;
+	    else if (!strcmp(*(argv + 1), "random"))
+		policy = RandomReplacement;
+	    else if (!strcmp(*(argv + 1), "clock"))
+		policy = ClockReplacement;
+	    else if (!strcmp(*(argv + 1), "ws"))
+		policy = WorkingSetReplacement;
+	    else
+		ASSERT(FALSE);		// unknown policy
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-mem")) {
+	    ASSERT(argc > 1);
+	    numFrames = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-loadcontrol"))
+	    useLoadControl = TRUE;
+	else if (!strcmp(*argv, "-merge"))
+	    useMerging = TRUE;
+	else if (!strcmp(*argv, "-swapcache")) {
+	    ASSERT(argc > 1);
+	    swapCacheBytes = atoi(*(argv + 1));
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -136,6 +221,8 @@ Initialize(int argc, char **argv)
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new ProcessScheduler();		// initialize the ready queue
+    sleepQueue = new SleepQueue();		// nobody asleep yet
+    processTable = new ProcessTable(InitialProcessTableSize);
     //if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -151,7 +238,42 @@ Initialize(int argc, char **argv)
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
+    // pages must be a power of two, and a whole number of sectors so
+    // that they can be swapped; large pages a power of two pages
+    ASSERT((PageSize >= SectorSize) && (PageSize <= MemorySize)
+	   && ((PageSize & (PageSize - 1)) == 0));
+    ASSERT((largePagePages >= 1) && (largePagePages <= NumPhysPages)
+	   && ((largePagePages & (largePagePages - 1)) == 0));
+    ASSERT(faultAroundPages >= 0);
     machine = new Machine(debugUserProg);	// this must come first
+#ifdef VM
+    if (numFrames == 0)
+	numFrames = NumPhysPages;
+    ASSERT((numFrames > 0) && (numFrames <= NumPhysPages));
+    frameAllocator = new FrameAllocator(numFrames);
+#else
+    frameAllocator = new FrameAllocator(NumPhysPages);
+#endif
+    textPageCache = new TextPageCache(NumPhysPages);
+    pagingLock = new Lock("paging");
+    synchConsole = NULL;			// started with the first user
+						// program, see LaunchUserProcess
+    InitializeSyscalls();
+#endif
+
+#ifdef VM
+    coreMap = new CoreMap(numFrames, policy);
+    ASSERT(swapCacheBytes >= 0);
+    swapSpace = new SwapSpace("SWAP", swapCacheBytes);
+    if (useLoadControl)
+	loadControl = new LoadControl(numFrames);
+    else
+	loadControl = NULL;
+    if (useMerging) {
+	pageMerger = new PageMerger(numFrames);
+	pageMerger->Start();
+    } else
+	pageMerger = NULL;
 #endif
 
 #ifdef FILESYS
@@ -179,7 +301,18 @@ Cleanup()
     delete postOffice;
 #endif
     
+#ifdef VM
+    delete pageMerger;
+    delete loadControl;
+    delete swapSpace;
+    delete coreMap;
+#endif
+
 #ifdef USER_PROGRAM
+    delete synchConsole;
+    delete pagingLock;
+    delete textPageCache;
+    delete frameAllocator;
     delete machine;
 #endif
 
@@ -192,6 +325,8 @@ Cleanup()
 #endif
     
     delete timer;
+    delete sleepQueue;
+    delete processTable;
     delete scheduler;
     delete interrupt;
     
@@ -15,6 +15,8 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "sleepqueue.h"
+#include "processtable.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -28,12 +30,39 @@ extern ProcessScheduler *scheduler;			// the thread scheduler
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
-
-extern bool initializedConsoleSemaphores;       // Used to initialize the semaphores for console I/O exactly once
+extern SleepQueue *sleepQueue;			// threads waiting for a time
+extern ProcessTable *processTable;		// threads by pid
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "frameallocator.h"
+#include "textcache.h"
+#include "synchconsole.h"
+#include "synch.h"
 extern Machine* machine;	// user program memory and registers
+extern FrameAllocator *frameAllocator;	// free physical page frames
+extern TextPageCache *textPageCache;	// code pages shared between processes
+extern SynchConsole *synchConsole;	// terminal for console system calls
+extern int largePagePages;		// pages per large page, or 1
+extern int faultAroundPages;		// most pages brought in after a
+					// faulting one
+extern void InitializeSyscalls();	// set up the system call table
+extern Lock *pagingLock;		// serializes page faults, which may
+					// have to wait for the swap disk
+#endif
+
+#ifdef VM
+#include "coremap.h"
+#include "swapspace.h"
+#include "loadcontrol.h"
+#include "pagemerger.h"
+extern CoreMap *coreMap;		// which page each frame holds, and
+					// which one to evict
+extern SwapSpace *swapSpace;		// backing store for evicted pages
+extern LoadControl *loadControl;	// keeps working sets within memory;
+					// NULL unless -loadcontrol
+extern PageMerger *pageMerger;		// merges identical pages; NULL
+					// unless -merge
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -29,18 +29,27 @@
 // 	Initialize a thread control block, so that we can then call
 //	NachOSThread::ThreadFork.
 //
+//	Each thread gets a pid from the process table, as a child of the
+//	thread that created it.  Only a thread given a user program by
+//	Fork can be joined (see ProcessTable::MakeJoinable).
+//
 //	"threadName" is an arbitrary string, useful for debugging.
 //----------------------------------------------------------------------
 
 NachOSThread::NachOSThread(char* threadName)
 {
     name = threadName;
+    pid = processTable->Allocate(this,
+		(currentThread != NULL) ? currentThread->getPID() : 0);
+    exitStatus = 0;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    readySince = runningSince = stats->totalTicks;
+    waitTicks = runTicks = 0;
+    voluntarySwitches = involuntarySwitches = 0;
 #ifdef USER_PROGRAM
     space = NULL;
-    stateRestored = true;
 #endif
 }
 
@@ -58,9 +67,14 @@ NachOSThread::NachOSThread(char* threadName)
 
 NachOSThread::~NachOSThread()
 {
-    DEBUG('t', "Deleting thread \"%s\"\n", name);
+    DEBUG('t', "Deleting thread \"%s\": waited %d ticks, ran %d ticks, "
+	  "%d voluntary and %d involuntary switches\n", name, waitTicks,
+	  runTicks, voluntarySwitches, involuntarySwitches);
 
     ASSERT(this != currentThread);
+#ifdef USER_PROGRAM
+    scheduler->ReleaseUserRegisters(this);
+#endif
     if (stack != NULL)
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
 }
@@ -125,6 +139,18 @@ NachOSThread::CheckOverflow()
 #endif
 }
 
+//----------------------------------------------------------------------
+// NachOSThread::getPPID
+// 	Return the pid of our parent, or 0 if it has finished (or we
+//	never had one).
+//----------------------------------------------------------------------
+
+int
+NachOSThread::getPPID()
+{
+    return processTable->GetParent(pid);
+}
+
 //----------------------------------------------------------------------
 // NachOSThread::FinishThread
 // 	Called by ThreadRoot when a thread is done executing the 
@@ -138,6 +164,9 @@ NachOSThread::CheckOverflow()
 //
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
+//
+//	The process table is told first, so the exit status is there
+//	for the parent to Join, and a parent already waiting is woken.
 //----------------------------------------------------------------------
 
 //
@@ -149,6 +178,7 @@ NachOSThread::FinishThread ()
     
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
     
+    processTable->Exit(pid, exitStatus);	// wakes a joining parent
     threadToBeDestroyed = currentThread;
     PutThreadToSleep();					// invokes SWITCH
     // not reached
@@ -186,7 +216,8 @@ NachOSThread::YieldCPU ()
     if (nextThread != NULL) {
 	scheduler->MoveThreadToReadyQueue(this);
 	scheduler->ScheduleThread(nextThread);
-    }
+    } else
+	scheduler->CancelPreemption();	// nobody to preempt us for
     (void) interrupt->SetLevel(oldLevel);
 }
 
@@ -299,11 +330,8 @@ NachOSThread::CreateThreadStack (VoidFunctionPtr func, int arg)
 void
 NachOSThread::SaveUserState()
 {
-    if (stateRestored) {
-       for (int i = 0; i < NumTotalRegs; i++)
-	  userRegisters[i] = machine->ReadRegister(i);
-       stateRestored = false;
-    }
+    for (int i = 0; i < NumTotalRegs; i++)
+	userRegisters[i] = machine->ReadRegister(i);
 }
 
 //----------------------------------------------------------------------
@@ -320,6 +348,5 @@ NachOSThread::RestoreUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
-    stateRestored = true;
 }
 #endif
@@ -99,9 +99,23 @@ class NachOSThread {
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
+    int getPID() { return pid; }
+    int getPPID();			// Parent's pid, or 0 if it is gone
+    void setExitStatus(int st) { exitStatus = st; }
+					// Status for the parent to Join
     void Print() { printf("%s, ", name); }
 
+    // Scheduling statistics, maintained by ProcessScheduler.
+    int readySince;			// when we were last put on the
+					// ready list
+    int runningSince;			// when we were last dispatched
+    int waitTicks;			// total time spent on the ready list
+    int runTicks;			// total time spent running
+    int voluntarySwitches;		// times we yielded, blocked or finished
+    int involuntarySwitches;		// times we were preempted
+
   private:
     // some of the private data for this class is listed above
     
@@ -115,7 +129,9 @@ class NachOSThread {
     					// Allocate a stack for thread.
 					// Used internally by ThreadFork()
 
-    int pid, ppid;			// My pid and my parent's pid
+    int pid;				// My pid, from the process table
+    int exitStatus;			// Handed to the process table when
+					// we finish
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
@@ -123,7 +139,8 @@ class NachOSThread {
 // while executing kernel code.
 
     int userRegisters[NumTotalRegs];	// user-level CPU register state
-    bool stateRestored;
+					// (stale while we own the machine
+					// registers, see ProcessScheduler)
 
   public:
     void SaveUserState();		// save user-level register state
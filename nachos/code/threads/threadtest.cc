@@ -5,12 +5,15 @@
 //	back and forth between themselves by calling NachOSThread::YieldCPU, 
 //	to illustratethe inner workings of the thread system.
 //
+//	Also contains microbenchmarks for the synchronization primitives.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
 #include "system.h"
+#include "synch.h"
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -49,3 +52,144 @@ ThreadTest()
     SimpleThread(0);
 }
 
+//----------------------------------------------------------------------
+// Synchronization microbenchmarks
+//	Measure, in simulated ticks, how long a fixed workload takes
+//	when it is protected by a plain Lock versus an RWLock, and how
+//	much a Barrier costs per phase.  Threads yield the CPU inside
+//	their critical sections, so readers overlap only if the lock
+//	actually lets them.
+//----------------------------------------------------------------------
+
+#define BenchReaders	8	// reader threads per run
+#define BenchWriters	2	// writer threads per run
+#define BenchOps	20	// critical sections per thread
+#define BenchWork	3	// yields inside each critical section
+#define BenchPhases	50	// barrier phases
+
+static Lock *benchLock;		// exclusive lock, for the baseline
+static RWLock *benchRWLock;	// reader-writer lock under test
+static Barrier *benchBarrier;
+static Semaphore *benchDone;	// V'ed by each worker when it finishes
+static int benchReadersInside, benchMaxReadersInside;
+
+static void
+BenchWorkInside(bool reading)
+{
+    if (reading) {
+	benchReadersInside++;
+	if (benchReadersInside > benchMaxReadersInside)
+	    benchMaxReadersInside = benchReadersInside;
+    }
+    for (int i = 0; i < BenchWork; i++)
+	currentThread->YieldCPU();
+    if (reading)
+	benchReadersInside--;
+}
+
+static void
+LockBenchThread(int reading)
+{
+    for (int i = 0; i < BenchOps; i++) {
+	benchLock->Acquire();
+	BenchWorkInside(reading);
+	benchLock->Release();
+	currentThread->YieldCPU();
+    }
+    benchDone->V();
+}
+
+static void
+RWLockBenchThread(int reading)
+{
+    for (int i = 0; i < BenchOps; i++) {
+	if (reading) {
+	    benchRWLock->ReadAcquire();
+	    BenchWorkInside(TRUE);
+	    benchRWLock->ReadRelease();
+	} else {
+	    benchRWLock->WriteAcquire();
+	    BenchWorkInside(FALSE);
+	    benchRWLock->WriteRelease();
+	}
+	currentThread->YieldCPU();
+    }
+    benchDone->V();
+}
+
+static void
+BarrierBenchThread(int which)
+{
+    for (int i = 0; i < BenchPhases; i++)
+	benchBarrier->Wait();
+    benchDone->V();
+}
+
+//----------------------------------------------------------------------
+// RunBench
+// 	Fork "readers" + "writers" copies of "func", wait for all of them
+//	to finish, and return the number of ticks that took.
+//----------------------------------------------------------------------
+
+static int
+RunBench(VoidFunctionPtr func, int readers, int writers)
+{
+    NachOSThread *t;
+    int start = stats->totalTicks;
+    int i;
+
+    benchReadersInside = benchMaxReadersInside = 0;
+    for (i = 0; i < readers + writers; i++) {
+	if (i < readers)
+	    t = new NachOSThread("bench reader");
+	else
+	    t = new NachOSThread("bench writer");
+	t->ThreadFork(func, i < readers);
+    }
+    for (i = 0; i < readers + writers; i++)
+	benchDone->P();
+    return stats->totalTicks - start;
+}
+
+//----------------------------------------------------------------------
+// SynchBenchmark
+// 	Run the Lock, RWLock (plain and fair) and Barrier microbenchmarks
+//	and print the results.  Invoked with "nachos -sb".
+//----------------------------------------------------------------------
+
+void
+SynchBenchmark()
+{
+    int ticks;
+
+    benchDone = new Semaphore("bench done", 0);
+
+    benchLock = new Lock("bench lock");
+    ticks = RunBench(LockBenchThread, BenchReaders, BenchWriters);
+    printf("Lock:          %d readers, %d writers, %d ops each: %d ticks, "
+	   "max readers inside %d\n", BenchReaders, BenchWriters, BenchOps,
+	   ticks, benchMaxReadersInside);
+    delete benchLock;
+
+    benchRWLock = new RWLock("bench rwlock");
+    ticks = RunBench(RWLockBenchThread, BenchReaders, BenchWriters);
+    printf("RWLock:        %d readers, %d writers, %d ops each: %d ticks, "
+	   "max readers inside %d\n", BenchReaders, BenchWriters, BenchOps,
+	   ticks, benchMaxReadersInside);
+    delete benchRWLock;
+
+    benchRWLock = new RWLock("bench fair rwlock", TRUE);
+    ticks = RunBench(RWLockBenchThread, BenchReaders, BenchWriters);
+    printf("RWLock (fair): %d readers, %d writers, %d ops each: %d ticks, "
+	   "max readers inside %d\n", BenchReaders, BenchWriters, BenchOps,
+	   ticks, benchMaxReadersInside);
+    delete benchRWLock;
+
+    benchBarrier = new Barrier("bench barrier", BenchReaders);
+    ticks = RunBench(BarrierBenchThread, BenchReaders, 0);
+    printf("Barrier:       %d threads, %d phases: %d ticks, %d ticks/phase\n",
+	   BenchReaders, BenchPhases, ticks, ticks / BenchPhases);
+    delete benchBarrier;
+
+    delete benchDone;
+}
@@ -15,6 +15,7 @@
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
+//   	'v' -- paging and swap (VM)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -18,7 +18,16 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
+#include "syscall.h"
+#ifdef FILESYS
+#include "filehdr.h"
+#endif
+#include <stddef.h>
+
+int ProcessAddressSpace::numSpaces = 0;
+
+static int nextTLBSlot = 0;		// TLB entry to replace next, when
+					// every entry is in use
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -42,26 +51,256 @@ SwapHeader (NoffHeader *noffH)
 	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
 }
 
+//----------------------------------------------------------------------
+// ReleaseFrame
+// 	Drop an address space's mapping of "frame", going through the
+//	text page cache if the frame holds a shared code page.
+//----------------------------------------------------------------------
+
+static void
+ReleaseFrame (int frame)
+{
+    if (!textPageCache->Release(frame))
+	frameAllocator->FreeFrame(frame);
+}
+
+//----------------------------------------------------------------------
+// Checkpoint files
+// 	A checkpoint file starts with a CheckpointHeader, describing the
+//	address space and the user registers, followed by a record for
+//	each open and mapped file, and then the names of the executable
+//	and of those files, one after another.  Only the records in use
+//	are written, so the header is small unless the process has many
+//	files open.  Then, at the page boundary the header gives, comes
+//	a place for every page of the address space, in order, preceded
+//	by a byte for each page, non-zero if the page is saved in the
+//	file.  Only the saved pages are ever written there.  Since a page
+//	always goes in the same place, a later checkpoint to the same
+//	file need only write the pages that have changed.
+//----------------------------------------------------------------------
+
+#define CheckpointMagic		0x434b5032	// "CKP2"
+#define CheckpointNameLength	100		// with the null byte
+#define CheckpointNamesSize	((1 + MaxOpenFiles + MaxFileMappings) \
+				 * CheckpointNameLength)
+
+struct CheckpointFile {
+    int id;				// OpenFileId
+    int position;			// Seek position
+    int name;				// Offset of its name in names[]
+};
+
+struct CheckpointMapping {
+    int firstPage;			// As in FileMapping
+    int numPages;
+    int length;
+    int name;				// Offset of its name in names[]
+};
+
+struct CheckpointHeader {
+    int magic;				// CheckpointMagic
+    int pageSize;			// PageSize when it was taken
+    int numVirtualPages;
+    int numImagePages;
+    int syscallRing;
+    int registers[NumTotalRegs];	// User registers to resume with
+    int dataOffset;			// Where the pages start in the file
+    int executableName;			// Offset of its name in names[]
+    int numFiles;			// Records used in files[]
+    int numMappings;			// ... and in mappings[]
+    int namesLength;			// Bytes used in names[]
+
+    // Only the used part of each of the following is in the file.
+    CheckpointFile files[MaxOpenFiles];
+    CheckpointMapping mappings[MaxFileMappings];
+    char names[CheckpointNamesSize];
+};
+
+#define CheckpointFixedSize	((int) offsetof(CheckpointHeader, files))
+
+//----------------------------------------------------------------------
+// CheckpointHeaderSize
+// 	The number of bytes "header" takes up in the file.
+//----------------------------------------------------------------------
+
+static int
+CheckpointHeaderSize (CheckpointHeader *header)
+{
+    return CheckpointFixedSize + header->numFiles * sizeof(CheckpointFile)
+	+ header->numMappings * sizeof(CheckpointMapping)
+	+ header->namesLength;
+}
+
+//----------------------------------------------------------------------
+// CheckpointDataOffset
+// 	The first page boundary after "header" and the saved page flags
+//	that follow it, where a checkpoint's pages can start.
+//----------------------------------------------------------------------
+
+static int
+CheckpointDataOffset (CheckpointHeader *header)
+{
+    return divRoundUp(CheckpointHeaderSize(header)
+		      + header->numVirtualPages, PageSize) * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddName
+// 	Add the file name "name" to the names in "header".  Returns its
+//	offset there, or -1 if it is too long to record.
+//----------------------------------------------------------------------
+
+static int
+AddName (CheckpointHeader *header, char *name)
+{
+    int offset = header->namesLength;
+
+    if (strlen(name) >= CheckpointNameLength)
+	return -1;
+    strcpy(&header->names[offset], name);
+    header->namesLength += strlen(name) + 1;
+    return offset;
+}
+
+//----------------------------------------------------------------------
+// IsName
+// 	Return TRUE if "offset" is the start of a name in "header", as
+//	read from a checkpoint.  ReadCheckpointHeader has checked that
+//	the names end with a null byte, so the name does too.
+//----------------------------------------------------------------------
+
+static bool
+IsName (CheckpointHeader *header, int offset)
+{
+    return (offset >= 0) && (offset < header->namesLength);
+}
+
+//----------------------------------------------------------------------
+// WriteCheckpointHeader, ReadCheckpointHeader
+// 	Move "header" between memory and the start of "file", leaving out
+//	the parts of the tables that aren't in use.  Reading checks that
+//	the counts of records and names are ones the tables can hold,
+//	before reading them in, and returns FALSE if they aren't, or the
+//	file is too short.
+//----------------------------------------------------------------------
+
+static void
+WriteCheckpointHeader (OpenFile *file, CheckpointHeader *header)
+{
+    int offset = CheckpointFixedSize;
+
+    file->WriteAt((char *) header, CheckpointFixedSize, 0);
+    file->WriteAt((char *) header->files,
+		  header->numFiles * sizeof(CheckpointFile), offset);
+    offset += header->numFiles * sizeof(CheckpointFile);
+    file->WriteAt((char *) header->mappings,
+		  header->numMappings * sizeof(CheckpointMapping), offset);
+    offset += header->numMappings * sizeof(CheckpointMapping);
+    file->WriteAt(header->names, header->namesLength, offset);
+}
+
+static bool
+ReadCheckpointHeader (OpenFile *file, CheckpointHeader *header)
+{
+    int offset = CheckpointFixedSize;
+    int size;
+
+    if ((file->ReadAt((char *) header, CheckpointFixedSize, 0)
+		!= CheckpointFixedSize)
+	    || (header->numFiles < 0) || (header->numFiles > MaxOpenFiles)
+	    || (header->numMappings < 0)
+	    || (header->numMappings > MaxFileMappings)
+	    || (header->namesLength <= 0)
+	    || (header->namesLength > CheckpointNamesSize))
+	return FALSE;
+    size = header->numFiles * sizeof(CheckpointFile);
+    if (file->ReadAt((char *) header->files, size, offset) != size)
+	return FALSE;
+    offset += size;
+    size = header->numMappings * sizeof(CheckpointMapping);
+    if (file->ReadAt((char *) header->mappings, size, offset) != size)
+	return FALSE;
+    offset += size;
+    size = header->namesLength;
+    if (file->ReadAt(header->names, size, offset) != size)
+	return FALSE;
+    return (header->names[header->namesLength - 1] == '\0');
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CountImagePages
+// 	Return the number of pages of code, data and stack the program in
+//	"executableFile" needs, or -1 if it can't be run: it isn't in
+//	NOFF format, or, without virtual memory, it needs more frames
+//	than there are.  Callers check this before giving up whatever
+//	the program is to replace, since the constructor can't fail.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::CountImagePages(OpenFile *executableFile)
+{
+    NoffHeader noffH;
+    int numPages;
+
+    if (executableFile->ReadAt((char *)&noffH, sizeof(noffH), 0)
+		!= sizeof(noffH))
+	return -1;
+    if ((noffH.noffMagic != NOFFMAGIC) && 
+		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
+    	SwapHeader(&noffH);
+    if ((noffH.noffMagic != NOFFMAGIC) || (noffH.code.size < 0)
+		|| (noffH.initData.size < 0) || (noffH.uninitData.size < 0))
+	return -1;
+    numPages = divRoundUp(noffH.code.size + noffH.initData.size
+			+ noffH.uninitData.size + UserStackSize, PageSize);
+#ifndef VM
+    if (numPages > NumPhysPages)	// can't run anything too big, at
+	return -1;			// least until we have virtual memory
+#endif
+    return numPages;
+}
+
 //----------------------------------------------------------------------
 // ProcessAddressSpace::ProcessAddressSpace
 // 	Create an address space to run a user program.
-//	Load the program from a file "executable", and set everything
-//	up so that we can start executing user instructions.
-//
-//	Assumes that the object code file is in NOFF format.
+//	The program is loaded from a file "executable" on demand: every
+//	page starts out invalid, and is given a frame and filled in by
+//	HandlePageFault the first time it is touched.  So starting a
+//	program costs time in proportion to the pages it uses, not to
+//	the size of the binary.
 //
-//	First, set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	Assumes that the object code file is in NOFF format, and small
+//	enough to run; see CountImagePages.
 //
-//	"executable" is the file containing the object code to load into memory
+//	"executableFile" is the file containing the object code; it is
+//	kept open (and deleted) by the address space
+//	"fileName" is the name "executableFile" was opened with
 //----------------------------------------------------------------------
 
-ProcessAddressSpace::ProcessAddressSpace(OpenFile *executable)
+ProcessAddressSpace::ProcessAddressSpace(OpenFile *executableFile,
+					 char *fileName)
+{
+    InitImage(executableFile, fileName);
+    InitFileTables(NULL);
+    numSpaces++;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::InitImage
+// 	The work of the constructor above, shared with the one that
+//	restores a checkpoint: read the NOFF header of "executableFile",
+//	and set up a page table with every page of the program and its
+//	stack invalid.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::InitImage(OpenFile *executableFile, char *fileName)
 {
-    NoffHeader noffH;
     unsigned int i, size;
 
+    executable = executableFile;
+    executableName = new char[strlen(fileName) + 1];
+    strcpy(executableName, fileName);
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
@@ -75,54 +314,1474 @@ ProcessAddressSpace::ProcessAddressSpace(OpenFile *executable)
     numVirtualPages = divRoundUp(size, PageSize);
     size = numVirtualPages * PageSize;
 
-    ASSERT(numVirtualPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+#ifndef VM
+    ASSERT(numVirtualPages <= (unsigned) NumPhysPages);
+					// check we're not trying to run
+					// anything too big -- at least
+					// until we have virtual memory
+#endif
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
 					numVirtualPages, size);
-// first, set up the translation 
+// set up the translation; no page has a frame yet
     KernelPageTable = new TranslationEntry[numVirtualPages];
+    copyOnWrite = new bool[numVirtualPages];
+    checkpointed = new bool[numVirtualPages];
+#ifdef VM
+    swapSlots = new int[numVirtualPages];
+    lastUses = new int[numVirtualPages];
+#endif
     for (i = 0; i < numVirtualPages; i++) {
-	KernelPageTable[i].virtualPage = i;	// for now, virtual page # = phys page #
-	KernelPageTable[i].physicalPage = i;
-	KernelPageTable[i].valid = TRUE;
+	KernelPageTable[i].virtualPage = i;
+	KernelPageTable[i].physicalPage = -1;
+	KernelPageTable[i].numPages = 1;
+	KernelPageTable[i].valid = FALSE;
 	KernelPageTable[i].use = FALSE;
 	KernelPageTable[i].dirty = FALSE;
 	KernelPageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
 					// a separate page, we could set its 
 					// pages to be read-only
+	copyOnWrite[i] = FALSE;
+	checkpointed[i] = FALSE;
+#ifdef VM
+	swapSlots[i] = -1;
+	lastUses[i] = -WorkingSetWindow - 1;
+#endif
+    }
+    numImagePages = numVirtualPages;
+    numResident = peakResident = 0;
+    numPageFaults = numPageIns = numPageOuts = 0;
+    faultAroundWindow = 0;
+    nextSequentialPage = -1;
+    syscallRing = -1;
+    checkpointName = NULL;
+    checkpointPages = 0;
+    checkpointDataOffset = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ProcessAddressSpace
+// 	Create a duplicate of "parent" for a forked child.  Nothing is
+//	copied: every page the parent has brought in is shared with the
+//	child, and made read-only in both page tables, so that whoever
+//	writes it first gets a private copy (see HandleReadOnlyFault).
+//	Pages the parent never touched are loaded on demand by the child
+//	from its own copy of the executable.  So the cost of a Fork is
+//	proportional to the size of the page table, and a child that
+//	Execs straight away copies nothing at all.
+//
+//	The child gets its own handles on the parent's open and mapped
+//	files.  Mapped pages the parent has touched are shared like any
+//	others, so after the Fork each side's writes to them are private
+//	until written back.
+//
+//	Pages the parent has swapped out are shared the same way: the
+//	child holds the parent's swap slot too, and whoever evicts the
+//	page after writing to it gets a slot of its own (see EvictPage).
+//	Shared pages are marked dirty in the child, which has no slot
+//	for them, so that they are written to swap when their frame is
+//	evicted; code pages from the text page cache are the exception,
+//	since the child can read them in from its executable as well.
+//	Under VM, the child's pages go in the core map too, so the frames
+//	it shares can still be evicted.
+//
+//	The child starts with no checkpoint of its own.
+//----------------------------------------------------------------------
+
+ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parent)
+{
+    unsigned int i;
+
+    executableName = new char[strlen(parent->executableName) + 1];
+    strcpy(executableName, parent->executableName);
+    executable = fileSystem->Open(executableName);
+    ASSERT(executable != NULL);
+    noffH = parent->noffH;
+    numVirtualPages = parent->numVirtualPages;
+    numImagePages = parent->numImagePages;
+
+    DEBUG('a', "Forking address space, num pages %d\n", numVirtualPages);
+    pagingLock->Acquire();
+    parent->FlushTLB();			// its pages are about to become
+					// read-only
+    KernelPageTable = new TranslationEntry[numVirtualPages];
+    copyOnWrite = new bool[numVirtualPages];
+    checkpointed = new bool[numVirtualPages];
+#ifdef VM
+    swapSlots = new int[numVirtualPages];
+    lastUses = new int[numVirtualPages];
+#endif
+    numResident = peakResident = 0;
+    numPageFaults = numPageIns = numPageOuts = 0;
+    faultAroundWindow = 0;
+    nextSequentialPage = -1;
+    checkpointName = NULL;
+    checkpointPages = 0;
+    checkpointDataOffset = 0;
+    for (i = 0; i < numVirtualPages; i++) {
+	if (parent->KernelPageTable[i].valid
+		&& !parent->copyOnWrite[i]) {	// may be read-only just
+						// for a checkpoint
+	    parent->KernelPageTable[i].readOnly = TRUE;
+	    parent->copyOnWrite[i] = TRUE;
+	}
+	KernelPageTable[i] = parent->KernelPageTable[i];
+	KernelPageTable[i].use = FALSE;
+	copyOnWrite[i] = parent->copyOnWrite[i];
+	checkpointed[i] = FALSE;
+	if (KernelPageTable[i].valid) {
+	    frameAllocator->ShareFrame(KernelPageTable[i].physicalPage);
+	    CountResident(1);
+#ifdef VM
+	    coreMap->MapFrame(KernelPageTable[i].physicalPage, this, i);
+#endif
+	}
+#ifdef VM
+	swapSlots[i] = -1;
+	lastUses[i] = -WorkingSetWindow - 1;
+	if (KernelPageTable[i].valid && (i < numImagePages)
+		&& !(IsTextPage(i)
+		     && textPageCache->Holds(KernelPageTable[i].physicalPage)))
+	    KernelPageTable[i].dirty = TRUE;
+	else if (parent->swapSlots[i] != -1) {
+	    swapSlots[i] = parent->swapSlots[i];
+	    swapSpace->ShareSlot(swapSlots[i]);
+	}
+#endif
+    }
+    pagingLock->Release();
+    syscallRing = -1;			// the requests in the parent's
+					// ring are the parent's
+    InitFileTables(parent);
+    numSpaces++;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::Restore
+// 	Recreate the address space saved in "checkpoint" by Checkpoint,
+//	so that the process can carry on from where it was taken.  The
+//	checkpoint is checked first: it must have been taken with the
+//	same page size, and the executable and mapped files must still
+//	be there, with the program laid out as it was.  Open files are
+//	more forgiving; one that can't be opened any more is left closed.
+//	Every count in the header is checked against the tables it
+//	describes, and the size of the address space against the size of
+//	the file, before anything is allocated according to them.
+//
+//	The saved pages aren't read in yet; once the caller has freed
+//	the frames of the address space this one replaces, it does that
+//	with RestorePages.
+//
+//	"checkpoint" is the checkpoint file, opened from "fileName"
+//	"registers" is set to the NumTotalRegs user registers to resume
+//	with
+//
+//	Returns the new address space, or NULL, having changed nothing,
+//	if "checkpoint" can't be restored.
+//----------------------------------------------------------------------
+
+ProcessAddressSpace *
+ProcessAddressSpace::Restore(OpenFile *checkpoint, char *fileName,
+			     int *registers)
+{
+    CheckpointHeader *header = new CheckpointHeader;
+    OpenFile *executableFile = NULL;
+    OpenFile *mappedFiles[MaxFileMappings];
+    CheckpointMapping *cm;
+    ProcessAddressSpace *space = NULL;
+    bool ok;
+    int i;
+
+    for (i = 0; i < MaxFileMappings; i++)
+	mappedFiles[i] = NULL;
+    ok = ReadCheckpointHeader(checkpoint, header)
+	&& (header->magic == CheckpointMagic)
+	&& (header->pageSize == PageSize)
+	&& (header->numImagePages > 0)
+	&& (header->numVirtualPages >= header->numImagePages)
+	&& (header->dataOffset % PageSize == 0)
+	&& (header->dataOffset <= checkpoint->Length())
+	&& (header->dataOffset - header->numVirtualPages
+		>= CheckpointHeaderSize(header))
+	&& IsName(header, header->executableName);
+    if (ok) {
+	executableFile =
+		fileSystem->Open(&header->names[header->executableName]);
+	ok = (executableFile != NULL)
+	    && (CountImagePages(executableFile) == header->numImagePages);
+    }
+    for (i = 0; ok && (i < header->numFiles); i++)
+	ok = (header->files[i].id >= 0)
+	    && (header->files[i].id < MaxOpenFiles)
+	    && IsName(header, header->files[i].name);
+    for (i = 0; ok && (i < header->numMappings); i++) {
+	cm = &header->mappings[i];
+	ok = IsName(header, cm->name)
+	    && (cm->length > 0)
+	    && (cm->numPages == divRoundUp(cm->length, PageSize))
+	    && (cm->firstPage >= header->numImagePages)
+	    && (cm->numPages <= header->numVirtualPages - cm->firstPage);
+	if (ok) {
+	    mappedFiles[i] = fileSystem->Open(&header->names[cm->name]);
+	    ok = (mappedFiles[i] != NULL);
+	}
+    }
+
+    if (ok) {
+	for (i = 0; i < NumTotalRegs; i++)
+	    registers[i] = header->registers[i];
+	space = new ProcessAddressSpace(header, executableFile, mappedFiles,
+					fileName);
+    } else {
+	DEBUG('a', "Restore: %s is not a usable checkpoint\n", fileName);
+	delete executableFile;
+	for (i = 0; i < MaxFileMappings; i++)
+	    delete mappedFiles[i];
+    }
+    delete header;
+    return space;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ProcessAddressSpace
+// 	The work of Restore, once it has checked the checkpoint: set up
+//	the program from "executableFile" as usual, grow the address
+//	space to the size it had, and reopen the open and mapped files
+//	described by "header".  The address space takes ownership of
+//	"executableFile" and of the "mappedFiles", one per mapping.
+//----------------------------------------------------------------------
+
+ProcessAddressSpace::ProcessAddressSpace(CheckpointHeader *header,
+					 OpenFile *executableFile,
+					 OpenFile **mappedFiles,
+					 char *fileName)
+{
+    CheckpointFile *f;
+    CheckpointMapping *cm;
+    FileMapping *m;
+    OpenFile *file;
+    char *name;
+    int i;
+
+    InitImage(executableFile, &header->names[header->executableName]);
+    ASSERT(numImagePages == (unsigned) header->numImagePages);
+    if (header->numVirtualPages > (int) numVirtualPages)
+	ResizePageTable(header->numVirtualPages);
+    syscallRing = header->syscallRing;
+
+    InitFileTables(NULL);
+    for (i = 0; i < header->numFiles; i++) {
+	f = &header->files[i];
+	name = &header->names[f->name];
+	if (openFiles[f->id] != NULL)
+	    continue;
+	file = fileSystem->Open(name);
+	if (file == NULL) {
+	    DEBUG('a', "Restore: unable to reopen file %s\n", name);
+	    continue;
+	}
+	file->Seek(f->position);
+	openFiles[f->id] = file;
+	openFileNames[f->id] = new char[strlen(name) + 1];
+	strcpy(openFileNames[f->id], name);
+    }
+    for (i = 0; i < header->numMappings; i++) {
+	cm = &header->mappings[i];
+	m = &mappings[i];
+	m->firstPage = cm->firstPage;
+	m->numPages = cm->numPages;
+	m->length = cm->length;
+	m->fileName = new char[strlen(&header->names[cm->name]) + 1];
+	strcpy(m->fileName, &header->names[cm->name]);
+	m->file = mappedFiles[i];
+    }
+
+    checkpointName = new char[strlen(fileName) + 1];
+    strcpy(checkpointName, fileName);
+    checkpointPages = numVirtualPages;
+    checkpointDataOffset = header->dataOffset;
+    numSpaces++;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::RestorePages
+// 	Read the pages saved in "checkpoint", which Restore made this
+//	address space from, back into memory, all at once; the rest are
+//	loaded on demand, as they were the first time.  The restored
+//	pages are the same as in the checkpoint, so the next checkpoint
+//	to the same file carries on from this one.
+//
+//	Returns FALSE if there is no frame for a saved page; the pages
+//	read in so far stay, for the destructor to free.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::RestorePages(OpenFile *checkpoint)
+{
+    int dataOffset = checkpointDataOffset;
+    char *saved = new char[numVirtualPages];
+    unsigned int vpn;
+    int frame;
+
+    DEBUG('a', "Restoring address space from %s, num pages %d\n",
+	  checkpointName, numVirtualPages);
+    bzero(saved, numVirtualPages);
+    checkpoint->ReadAt(saved, numVirtualPages, dataOffset - numVirtualPages);
+    pagingLock->Acquire();
+    for (vpn = 0; vpn < numVirtualPages; vpn++) {
+	if (!saved[vpn])
+	    continue;
+	frame = GetFrame();
+	if (frame == -1)
+	    break;
+	bzero(&(machine->mainMemory[frame * PageSize]), PageSize);
+	checkpoint->ReadAt(&(machine->mainMemory[frame * PageSize]),
+			   PageSize, dataOffset + vpn * PageSize);
+	KernelPageTable[vpn].physicalPage = frame;
+	KernelPageTable[vpn].valid = TRUE;
+	KernelPageTable[vpn].dirty = TRUE;	// not what the executable
+						// or mapped file holds
+	KernelPageTable[vpn].readOnly = TRUE;	// see Checkpoint
+	checkpointed[vpn] = TRUE;
+	CountResident(1);
+#ifdef VM
+	coreMap->MapFrame(frame, this, vpn);
+#endif
     }
-    
-// zero out the entire address space, to zero the unitialized data segment 
-// and the stack segment
-    bzero(machine->mainMemory, size);
+    pagingLock->Release();
+    delete [] saved;
+    return (vpn == numVirtualPages);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::InitFileTables
+// 	Set up an empty file table and no mappings, or, if "parent" is
+//	not NULL, reopen each of the parent's open and mapped files.
+//	The first two file table entries are the console, which is not
+//	in the table.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::InitFileTables(ProcessAddressSpace *parent)
+{
+    int i;
+    FileMapping *m;
 
-// then, copy in the code and data segments into memory
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-			noffH.code.virtualAddr, noffH.code.size);
-        executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
-			noffH.code.size, noffH.code.inFileAddr);
+    for (i = 0; i < MaxOpenFiles; i++) {
+	openFiles[i] = NULL;
+	openFileNames[i] = NULL;
+	if ((parent == NULL) || (parent->openFiles[i] == NULL))
+	    continue;
+	openFiles[i] = fileSystem->Open(parent->openFileNames[i]);
+	if (openFiles[i] != NULL) {
+	    openFileNames[i] = new char[strlen(parent->openFileNames[i]) + 1];
+	    strcpy(openFileNames[i], parent->openFileNames[i]);
+	}
     }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-			noffH.initData.virtualAddr, noffH.initData.size);
-        executable->ReadAt(&(machine->mainMemory[noffH.initData.virtualAddr]),
-			noffH.initData.size, noffH.initData.inFileAddr);
+    for (i = 0; i < MaxFileMappings; i++) {
+	m = &mappings[i];
+	if (parent != NULL)
+	    *m = parent->mappings[i];
+	else
+	    m->firstPage = -1;
+	if (m->firstPage == -1)
+	    continue;
+	m->fileName = new char[strlen(m->fileName) + 1];
+	strcpy(m->fileName, parent->mappings[i].fileName);
+	m->file = fileSystem->Open(m->fileName);
+	ASSERT(m->file != NULL);
     }
+}
 
+//----------------------------------------------------------------------
+// ProcessAddressSpace::HandlePageFault
+// 	Called on a PageFaultException at "virtAddr".  Give the page a
+//	frame, and fill it in from the code and initialized data segments
+//	of the executable.  Whatever isn't covered by either segment
+//	(uninitialized data and the stack) is left as the zeroes the
+//	frame allocator hands back.
+//
+//	Pages holding nothing but code are shared, through the text page
+//	cache, with every other process running the same executable.
+//	They are mapped copy-on-write, in case anybody does write to them.
+//	Under VM they go in the core map like any other page, so that a
+//	cached frame can be evicted; being clean, it is just dropped
+//	from every page mapping it.
+//
+//	Pages past the program and its stack belong to mapped files, and
+//	are read in from the file.
+//
+//	Under VM, a page that was written to and then evicted is read
+//	back from its swap slot instead, and a page that is already
+//	valid was only missing from the TLB.
+//
+//	With -largepages, the whole large page around a code or data page
+//	is brought in at once if it can be (see LoadLargePage).  With
+//	-faultaround, a fault that continues a run of sequential faults
+//	brings in some of the following pages too (see FaultAround).
+//
+//	Returns FaultBadAddress if "virtAddr" is outside the address
+//	space, in which case the caller has a bad pointer on its hands,
+//	and FaultNoMemory if no frame can be found for the page.
+//----------------------------------------------------------------------
+
+FaultResult
+ProcessAddressSpace::HandlePageFault(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    int frame, offset;
+
+    FileMapping *m = NULL;
+
+    if (virtAddr < 0 || vpn >= numVirtualPages)
+	return FaultBadAddress;
+    if (vpn >= numImagePages) {
+	m = FindMapping(vpn);
+	if (m == NULL)			// hole left by an Munmap
+	    return FaultBadAddress;
+    }
+
+#ifdef VM
+    if (loadControl != NULL)
+	loadControl->CheckPressure(this);	// may suspend us for a while
+#endif
+    pagingLock->Acquire();
+    if (KernelPageTable[vpn].valid) {	// a TLB miss, or someone else
+	LoadTLB(vpn);			// already brought it in
+	pagingLock->Release();
+	return FaultHandled;
+    }
+
+    if ((m == NULL) && LoadLargePage(vpn)) {
+	LoadTLB(vpn);
+	stats->numPageFaults++;
+	numPageFaults++;
+	pagingLock->Release();
+	return FaultHandled;
+    }
+
+    if (m != NULL) {
+	frame = GetFrame();
+	if (frame == -1) {
+	    pagingLock->Release();
+	    return FaultNoMemory;
+	}
+	offset = (vpn - m->firstPage) * PageSize;
+	DEBUG('a', "Page fault at 0x%x, reading %s:%d into frame %d\n",
+					virtAddr, m->fileName, offset, frame);
+	KernelPageTable[vpn].physicalPage = frame;
+	m->file->ReadAt(&(machine->mainMemory[frame * PageSize]),
+			min(PageSize, m->length - offset), offset);
+#ifdef VM
+    } else if (swapSlots[vpn] != -1) {
+	frame = GetFrame();
+	if (frame == -1) {
+	    pagingLock->Release();
+	    return FaultNoMemory;
+	}
+	DEBUG('a', "Page fault at 0x%x, swapping page %d into frame %d\n",
+					virtAddr, vpn, frame);
+	KernelPageTable[vpn].physicalPage = frame;
+	swapSpace->ReadPage(swapSlots[vpn], frame);
+	stats->numPageIns++;
+	numPageIns++;
+#endif
+    } else if (IsTextPage(vpn)) {
+	offset = noffH.code.inFileAddr
+			+ (vpn * PageSize - noffH.code.virtualAddr);
+	frame = textPageCache->Lookup(executableName, offset);
+	if (frame == -1) {
+	    frame = GetFrame();
+	    if (frame == -1) {
+		pagingLock->Release();
+		return FaultNoMemory;
+	    }
+	    KernelPageTable[vpn].physicalPage = frame;
+	    CopyInSegment(&noffH.code, vpn);
+	    textPageCache->Insert(executableName, offset, frame);
+	}
+	DEBUG('a', "Page fault at 0x%x, mapping text page %d to frame %d\n",
+					virtAddr, vpn, frame);
+	KernelPageTable[vpn].physicalPage = frame;
+	KernelPageTable[vpn].readOnly = TRUE;
+	copyOnWrite[vpn] = TRUE;
+    } else {
+	frame = GetFrame();
+	if (frame == -1) {
+	    pagingLock->Release();
+	    return FaultNoMemory;
+	}
+	DEBUG('a', "Page fault at 0x%x, loading page %d into frame %d\n",
+					virtAddr, vpn, frame);
+	KernelPageTable[vpn].physicalPage = frame;
+	CopyInSegment(&noffH.code, vpn);
+	CopyInSegment(&noffH.initData, vpn);
+    }
+    if (checkpointed[vpn])		// watch for writes; see Checkpoint
+	KernelPageTable[vpn].readOnly = TRUE;
+    KernelPageTable[vpn].valid = TRUE;
+    KernelPageTable[vpn].use = FALSE;
+    KernelPageTable[vpn].dirty = FALSE;
+    CountResident(1);
+#ifdef VM
+    coreMap->MapFrame(frame, this, vpn);
+#endif
+    LoadTLB(vpn);
+    stats->numPageFaults++;
+    numPageFaults++;
+    if (faultAroundPages > 0) {
+	if ((int) vpn == nextSequentialPage)
+	    faultAroundWindow = min(max(2 * faultAroundWindow, 1),
+				    faultAroundPages);
+	else
+	    faultAroundWindow = 0;
+	nextSequentialPage = vpn + 1 + FaultAround(vpn, m);
+    }
+    pagingLock->Release();
+    return FaultHandled;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::HandleReadOnlyFault
+// 	Called on a ReadOnlyException at "virtAddr".  If the page is
+//	only read-only because its frame is shared copy-on-write, give
+//	it a private copy of the frame (or, if everyone else has already
+//	let go of the frame, just take it over) and make it writable.
+//
+//	A page saved by Checkpoint is also read-only, so that the first
+//	write to it is noticed: it is no longer the same as the copy in
+//	the checkpoint, and has to be saved again by the next one.
+//
+//	The shared frame is pinned while a frame for the copy is found,
+//	so that it isn't evicted from under us.
+//
+//	Returns FaultBadAddress if the page really is read-only, and
+//	FaultNoMemory if no frame can be found for the copy.
+//----------------------------------------------------------------------
+
+FaultResult
+ProcessAddressSpace::HandleReadOnlyFault(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    int oldFrame, newFrame;
+
+    if (virtAddr < 0 || vpn >= numVirtualPages)
+	return FaultBadAddress;
+
+    pagingLock->Acquire();
+    if (!copyOnWrite[vpn] && !checkpointed[vpn]) {
+	pagingLock->Release();
+	return FaultBadAddress;
+    }
+    checkpointed[vpn] = FALSE;
+    FlushTLB();				// the TLB still says read-only
+    oldFrame = KernelPageTable[vpn].physicalPage;
+    if (copyOnWrite[vpn] && (frameAllocator->RefCount(oldFrame) > 1)) {
+#ifdef VM
+	coreMap->PinFrame(oldFrame);
+	newFrame = GetFrame();
+	coreMap->UnpinFrame(oldFrame);
+#else
+	newFrame = GetFrame();
+#endif
+	if (newFrame == -1) {
+	    pagingLock->Release();
+	    return FaultNoMemory;
+	}
+	DEBUG('a', "Copy on write at 0x%x, page %d: frame %d -> %d\n",
+					virtAddr, vpn, oldFrame, newFrame);
+	bcopy(&(machine->mainMemory[oldFrame * PageSize]),
+	      &(machine->mainMemory[newFrame * PageSize]), PageSize);
+	DropFrame(vpn);
+	KernelPageTable[vpn].physicalPage = newFrame;
+    }
+    KernelPageTable[vpn].readOnly = FALSE;
+    copyOnWrite[vpn] = FALSE;
+#ifdef VM
+    coreMap->MapFrame(KernelPageTable[vpn].physicalPage, this, vpn);
+#endif
+    LoadTLB(vpn);
+    pagingLock->Release();
+    return FaultHandled;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CanFaultAround
+// 	Return TRUE if page "vpn" may be brought in by FaultAround, after
+//	a fault on an earlier page of the mapping "m" (or of the program's
+//	data, if "m" is NULL).  It must not be in memory yet, nor have
+//	anything in swap, and must belong to the same mapping, or lie
+//	in the data of the program.  Code pages go through the text page
+//	cache instead, and pages saved by a checkpoint through
+//	HandlePageFault, which write-protects them.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::CanFaultAround(int vpn, FileMapping *m)
+{
+    int dataEnd = max(noffH.initData.virtualAddr + noffH.initData.size,
+		      noffH.uninitData.virtualAddr + noffH.uninitData.size);
+
+    if (((unsigned) vpn >= numVirtualPages) || KernelPageTable[vpn].valid
+		|| checkpointed[vpn])
+	return FALSE;
+#ifdef VM
+    if (swapSlots[vpn] != -1)
+	return FALSE;
+#endif
+    if (m != NULL)
+	return vpn < m->firstPage + m->numPages;
+    return ((unsigned) vpn < numImagePages) && !IsTextPage(vpn)
+	&& (vpn * PageSize < dataEnd);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::FaultAround
+// 	After a fault on page "vpn", of mapping "m" or of the program if
+//	"m" is NULL, bring in up to faultAroundWindow of the pages right
+//	after it, so that a program sweeping through its data takes one
+//	fault for a run of pages rather than one for each.  The run stops
+//	at the first page that can't be brought in this way, and when
+//	there are no free frames left: making room would mean evicting
+//	pages that are in use to bring in pages that may never be.
+//
+//	The run is read in with one ReadAt per segment, rather than one
+//	per page, into a kernel buffer, and then copied into the frames.
+//	The pages aren't put in the TLB; the first access to each is a
+//	TLB miss, but not a page fault.
+//
+//	Returns the number of pages brought in.  The caller holds
+//	pagingLock.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::FaultAround(int vpn, FileMapping *m)
+{
+    int first = vpn + 1;
+    int count, i, frame;
+    int start, end, rangeStart, rangeEnd;
+    Segment *segments[2];
+    char *buffer;
+
+    for (count = 0; count < faultAroundWindow; count++)
+	if (!CanFaultAround(first + count, m))
+	    break;
+    count = min(count, frameAllocator->NumFree());
+    if (count == 0)
+	return 0;
+
+    rangeStart = first * PageSize;
+    rangeEnd = (first + count) * PageSize;
+    buffer = new char[count * PageSize];
+    bzero(buffer, count * PageSize);
+    if (m != NULL) {
+	start = rangeStart - m->firstPage * PageSize;
+	if (start < m->length)
+	    m->file->ReadAt(buffer, min(count * PageSize, m->length - start),
+			    start);
+    } else {
+	segments[0] = &noffH.code;
+	segments[1] = &noffH.initData;
+	for (i = 0; i < 2; i++) {
+	    start = max(rangeStart, segments[i]->virtualAddr);
+	    end = min(rangeEnd,
+		      segments[i]->virtualAddr + segments[i]->size);
+	    if ((segments[i]->size > 0) && (start < end))
+		executable->ReadAt(&buffer[start - rangeStart], end - start,
+			segments[i]->inFileAddr
+				+ (start - segments[i]->virtualAddr));
+	}
+    }
+
+    DEBUG('a', "Fault-around after page %d: bringing in pages %d-%d\n",
+	  vpn, first, first + count - 1);
+    for (i = 0; i < count; i++) {
+	frame = frameAllocator->AllocateFrame();
+	ASSERT(frame != -1);
+	bcopy(&buffer[i * PageSize],
+	      &(machine->mainMemory[frame * PageSize]), PageSize);
+	KernelPageTable[first + i].physicalPage = frame;
+	KernelPageTable[first + i].valid = TRUE;
+	KernelPageTable[first + i].use = FALSE;
+	KernelPageTable[first + i].dirty = FALSE;
+	CountResident(1);
+#ifdef VM
+	coreMap->MapFrame(frame, this, first + i);
+#endif
+    }
+    delete [] buffer;
+    stats->numFaultAroundPages += count;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::IsTextPage
+// 	Return TRUE if virtual page "vpn" lies entirely within the code
+//	segment, so that its contents are the same in every process
+//	running this executable.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::IsTextPage(int vpn)
+{
+    int pageStart = vpn * PageSize;
+
+    return (pageStart >= noffH.code.virtualAddr)
+	&& (pageStart + PageSize <= noffH.code.virtualAddr + noffH.code.size);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::IsModified
+// 	Return TRUE if virtual page "vpn" has been written to since it
+//	was loaded, so that its contents can't be had again from the
+//	executable or its mapped file: it is dirty, or, under VM, was
+//	dirty when it was evicted, and so has a swap slot.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::IsModified(int vpn)
+{
+    if (KernelPageTable[vpn].valid && KernelPageTable[vpn].dirty)
+	return TRUE;
+#ifdef VM
+    return swapSlots[vpn] != -1;
+#else
+    return FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CopyInSegment
+// 	Read the part of "segment" that overlaps virtual page "vpn" out
+//	of the executable and into the page's frame.  Does nothing if
+//	the two don't overlap.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::CopyInSegment(Segment *segment, int vpn)
+{
+    int pageStart = vpn * PageSize;
+    int start = max(pageStart, segment->virtualAddr);
+    int end = min(pageStart + PageSize,
+		  segment->virtualAddr + segment->size);
+
+    if (segment->size <= 0 || start >= end)
+	return;
+    executable->ReadAt(&(machine->mainMemory[
+		KernelPageTable[vpn].physicalPage * PageSize
+			+ (start - pageStart)]),
+		end - start, segment->inFileAddr + (start - segment->virtualAddr));
 }
 
 //----------------------------------------------------------------------
 // ProcessAddressSpace::~ProcessAddressSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space, returning the frames of the pages
+//	it touched to the frame allocator, and closing the executable.
+//	Mapped files are unmapped first, so that changes to them are
+//	written back, and open files are closed.  Under VM, the swap
+//	slots of pages that were evicted are freed too.
 //----------------------------------------------------------------------
 
 ProcessAddressSpace::~ProcessAddressSpace()
 {
-   delete KernelPageTable;
+   unsigned int i;
+
+#ifdef VM
+   if (loadControl != NULL)
+      loadControl->Leave(this);
+#endif
+   for (i = 0; i < MaxFileMappings; i++)
+      if (mappings[i].firstPage != -1)
+	 UnmapFile(mappings[i].firstPage * PageSize);
+   for (i = 0; i < MaxOpenFiles; i++)
+      CloseFile(i);
+   pagingLock->Acquire();
+   scheduler->DeactivateAddressSpace(this);
+   for (i = 0; i < numVirtualPages; i++) {
+      if (KernelPageTable[i].valid)
+	 DropFrame(i);
+#ifdef VM
+      if (swapSlots[i] != -1)
+	 swapSpace->FreeSlot(swapSlots[i]);
+#endif
+   }
+   pagingLock->Release();
+   delete [] KernelPageTable;
+   delete [] copyOnWrite;
+   delete [] checkpointed;
+#ifdef VM
+   delete [] swapSlots;
+   delete [] lastUses;
+#endif
+   delete executable;
+   delete [] executableName;
+   delete [] checkpointName;
+   numSpaces--;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::AddOpenFile
+// 	Enter "file", opened from "fileName", in the first free slot of
+//	the file table.  The address space takes ownership of "file".
+//
+//	Returns the OpenFileId for the file, or -1 if the table is full.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::AddOpenFile(OpenFile *file, char *fileName)
+{
+    int id;
+
+    for (id = ConsoleOutput + 1; id < MaxOpenFiles; id++)
+	if (openFiles[id] == NULL) {
+	    openFiles[id] = file;
+	    openFileNames[id] = new char[strlen(fileName) + 1];
+	    strcpy(openFileNames[id], fileName);
+	    return id;
+	}
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::GetOpenFile
+// 	Return the open file "id", or NULL if there is no such file.
+//----------------------------------------------------------------------
+
+OpenFile *
+ProcessAddressSpace::GetOpenFile(int id)
+{
+    if ((id < 0) || (id >= MaxOpenFiles))
+	return NULL;
+    return openFiles[id];
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CloseFile
+// 	Close the open file "id" and free its slot in the file table.
+//	Mappings of the file are not affected.
+//
+//	Returns FALSE if there is no such file.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::CloseFile(int id)
+{
+    if (GetOpenFile(id) == NULL)
+	return FALSE;
+    delete openFiles[id];
+    delete [] openFileNames[id];
+    openFiles[id] = NULL;
+    openFileNames[id] = NULL;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::MapFile
+// 	Map the first "length" bytes of the open file "id" into the
+//	address space, in the first hole an earlier mapping left that is
+//	big enough, or else at the end of it.  Nothing is read yet;
+//	pages come in from the file as they are touched (see
+//	HandlePageFault).  The mapping has its own handle on the file,
+//	so it outlives a Close of "id".
+//
+//	Must be called by the thread running in this address space.
+//
+//	Returns the virtual address of the mapping, or -1 if "id" isn't
+//	open, "length" isn't positive, or there are too many mappings.
+//	Without VM, nothing can be paged out, so the whole address space
+//	has to fit in memory: mappings that would make it too big are
+//	refused too.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::MapFile(int id, int length)
+{
+    FileMapping *m = NULL;
+    int i, first, numPages;
+#ifndef VM
+    int totalPages = numImagePages;
+#endif
+
+    if ((GetOpenFile(id) == NULL) || (length <= 0))
+	return -1;
+    numPages = divRoundUp(length, PageSize);
+    for (i = 0; i < MaxFileMappings; i++) {
+	if (mappings[i].firstPage == -1) {
+	    if (m == NULL)
+		m = &mappings[i];
+	}
+#ifndef VM
+	else
+	    totalPages += mappings[i].numPages;
+#endif
+    }
+    if (m == NULL)
+	return -1;
+#ifndef VM
+    if (totalPages + numPages > NumPhysPages)
+	return -1;
+#endif
+
+    m->file = fileSystem->Open(openFileNames[id]);
+    if (m->file == NULL)
+	return -1;
+    m->fileName = new char[strlen(openFileNames[id]) + 1];
+    strcpy(m->fileName, openFileNames[id]);
+    m->length = length;
+    m->numPages = numPages;
+    pagingLock->Acquire();
+    first = FindFreePages(numPages);
+    m->firstPage = first;
+    if ((unsigned) (first + numPages) > numVirtualPages) {
+	FlushTLB();
+	ResizePageTable(first + numPages);
+	RestoreContextOnSwitch();	// the page table has moved
+    }
+    pagingLock->Release();
+
+    DEBUG('a', "Mapped %d bytes of %s at 0x%x\n", length, m->fileName,
+	  m->firstPage * PageSize);
+    return m->firstPage * PageSize;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::UnmapFile
+// 	Remove the mapping starting at "virtAddr".  Pages that were
+//	written to are written back to the file first.  The virtual
+//	pages are left as a hole for a later mapping to reuse, unless
+//	no mapping follows them, in which case the address space
+//	shrinks back to the end of the last one.  A system call ring
+//	that lay in the mapping is unregistered.
+//
+//	Returns FALSE if no mapping starts at "virtAddr".
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::UnmapFile(int virtAddr)
+{
+    FileMapping *m;
+    TranslationEntry *entry;
+    int i, vpn, offset;
+    unsigned int end;
+
+    if ((virtAddr < 0) || (virtAddr % PageSize != 0))
+	return FALSE;
+    vpn = virtAddr / PageSize;
+    m = FindMapping(vpn);
+    if ((m == NULL) || (m->firstPage != vpn))
+	return FALSE;
+
+    pagingLock->Acquire();
+    FlushTLB();				// pick up the dirty bits
+    for (i = 0; i < m->numPages; i++) {
+	entry = &KernelPageTable[m->firstPage + i];
+	checkpointed[m->firstPage + i] = FALSE;
+	if (!entry->valid)
+	    continue;
+	if (entry->dirty) {
+	    offset = i * PageSize;
+	    DEBUG('a', "Writing back %s:%d from frame %d\n", m->fileName,
+		  offset, entry->physicalPage);
+	    m->file->WriteAt(&(machine->mainMemory[
+				entry->physicalPage * PageSize]),
+			     min(PageSize, m->length - offset), offset);
+	}
+	DropFrame(m->firstPage + i);
+	CountResident(-1);
+	entry->valid = FALSE;
+	entry->dirty = FALSE;
+	entry->readOnly = FALSE;
+	copyOnWrite[m->firstPage + i] = FALSE;
+    }
+    if ((syscallRing != -1)
+	    && (syscallRing + (int) sizeof(SyscallRing)
+		> m->firstPage * PageSize)
+	    && (syscallRing < (m->firstPage + m->numPages) * PageSize)) {
+	DEBUG('a', "Unregistering the system call ring at 0x%x\n",
+	      syscallRing);
+	syscallRing = -1;
+    }
+    delete m->file;
+    delete [] m->fileName;
+    m->firstPage = -1;
+
+    end = numImagePages;
+    for (i = 0; i < MaxFileMappings; i++)
+	if ((mappings[i].firstPage != -1)
+		&& ((unsigned) (mappings[i].firstPage + mappings[i].numPages)
+		    > end))
+	    end = mappings[i].firstPage + mappings[i].numPages;
+    if (end < numVirtualPages) {
+	ResizePageTable(end);
+	if (scheduler->ActiveAddressSpace() == this)
+	    RestoreContextOnSwitch();	// the page table has moved
+    }
+    pagingLock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::IsWritable
+// 	Return TRUE if the program may write every byte from "virtAddr"
+//	up to "virtAddr" + "size": each page must be part of the program
+//	other than its code, or of a mapping.  The kernel checks this
+//	before it keeps an address to write to later, since a write it
+//	makes there on its own behalf can't be allowed to fault.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::IsWritable(int virtAddr, int size)
+{
+    int vpn;
+
+    if ((virtAddr < 0) || (size <= 0))
+	return FALSE;
+    for (vpn = virtAddr / PageSize; vpn <= (virtAddr + size - 1) / PageSize;
+	 vpn++) {
+	if ((unsigned) vpn >= numVirtualPages)
+	    return FALSE;
+	if ((unsigned) vpn < numImagePages) {
+	    if (IsTextPage(vpn))
+		return FALSE;
+	} else if (FindMapping(vpn) == NULL)
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::FindMapping
+// 	Return the file mapping virtual page "vpn" belongs to, or NULL.
+//----------------------------------------------------------------------
+
+FileMapping *
+ProcessAddressSpace::FindMapping(int vpn)
+{
+    int i;
+
+    for (i = 0; i < MaxFileMappings; i++)
+	if ((mappings[i].firstPage != -1) && (vpn >= mappings[i].firstPage)
+		&& (vpn < mappings[i].firstPage + mappings[i].numPages))
+	    return &mappings[i];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::FindFreePages
+// 	Return the first page of a run of "numPages" pages past the
+//	program and its stack that no mapping uses.  The run may go on
+//	past the end of the address space, which then has to grow.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::FindFreePages(int numPages)
+{
+    FileMapping *m;
+    int i, first = numImagePages;
+
+    for (i = first; (i < first + numPages) && (i < (int) numVirtualPages);
+	 i++) {
+	m = FindMapping(i);
+	if (m != NULL) {
+	    first = m->firstPage + m->numPages;
+	    i = first - 1;
+	}
+    }
+    return first;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ResizePageTable
+// 	Grow or shrink the address space to "newSize" pages.  New pages
+//	are invalid for now; pages cut off must already be invalid, with
+//	nothing in swap.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::ResizePageTable(unsigned int newSize)
+{
+    TranslationEntry *oldTable = KernelPageTable;
+    bool *oldCopyOnWrite = copyOnWrite;
+    bool *oldCheckpointed = checkpointed;
+#ifdef VM
+    int *oldSwapSlots = swapSlots;
+    int *oldLastUses = lastUses;
+#endif
+    unsigned int i;
+
+    for (i = newSize; i < numVirtualPages; i++) {
+	ASSERT(!KernelPageTable[i].valid);
+#ifdef VM
+	ASSERT(swapSlots[i] == -1);
+#endif
+    }
+    KernelPageTable = new TranslationEntry[newSize];
+    copyOnWrite = new bool[newSize];
+    checkpointed = new bool[newSize];
+#ifdef VM
+    swapSlots = new int[newSize];
+    lastUses = new int[newSize];
+#endif
+    for (i = 0; i < newSize; i++) {
+	if (i < numVirtualPages) {
+	    KernelPageTable[i] = oldTable[i];
+	    copyOnWrite[i] = oldCopyOnWrite[i];
+	    checkpointed[i] = oldCheckpointed[i];
+#ifdef VM
+	    swapSlots[i] = oldSwapSlots[i];
+	    lastUses[i] = oldLastUses[i];
+#endif
+	    continue;
+	}
+	KernelPageTable[i].virtualPage = i;
+	KernelPageTable[i].physicalPage = -1;
+	KernelPageTable[i].numPages = 1;
+	KernelPageTable[i].valid = FALSE;
+	KernelPageTable[i].use = FALSE;
+	KernelPageTable[i].dirty = FALSE;
+	KernelPageTable[i].readOnly = FALSE;
+	copyOnWrite[i] = FALSE;
+	checkpointed[i] = FALSE;
+#ifdef VM
+	swapSlots[i] = -1;
+	lastUses[i] = -WorkingSetWindow - 1;
+#endif
+    }
+    delete [] oldTable;
+    delete [] oldCopyOnWrite;
+    delete [] oldCheckpointed;
+#ifdef VM
+    delete [] oldSwapSlots;
+    delete [] oldLastUses;
+#endif
+    numVirtualPages = newSize;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::GetFrame
+// 	Allocate a physical frame for one of our pages.  Under VM, if
+//	memory is full, ask the core map for a victim and evict it, from
+//	whichever address spaces map it.
+//
+//	Returns the frame, or -1 if memory is full and nothing can be
+//	evicted (always, without VM); the caller's process can't go on.
+//	The caller holds pagingLock.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::GetFrame()
+{
+    int frame = frameAllocator->AllocateFrame();
+#ifdef VM
+    int victim;
+
+    while (frame == -1) {
+	SyncTLB();			// so the policy sees fresh use bits
+	victim = coreMap->ChooseVictim();
+	if (victim == -1)		// every frame is pinned, or
+	    break;			// held by the kernel
+	coreMap->EvictFrame(victim);
+	frame = frameAllocator->AllocateFrame();
+    }
+#endif
+    if (frame == -1)
+	DEBUG('a', "Out of physical memory\n");
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::DropFrame
+// 	Let go of the frame holding page "vpn", taking the page out of
+//	the core map.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::DropFrame(int vpn)
+{
+#ifdef VM
+    coreMap->UnmapFrame(KernelPageTable[vpn].physicalPage, this, vpn);
+#endif
+    ReleaseFrame(KernelPageTable[vpn].physicalPage);
+}
+
+#ifdef VM
+//----------------------------------------------------------------------
+// ProcessAddressSpace::EvictPage
+// 	Take page "vpn" out of memory, letting go of its frame; the core
+//	map calls this for every page mapping a frame it evicts.  If the
+//	page has been written to, save it first: pages of a mapped file
+//	go back to the file, and all others to a swap slot, which the
+//	page keeps until the address space goes away.  A clean page is
+//	just dropped, since HandlePageFault can fetch it again from
+//	wherever it came from.
+//
+//	A frame shared copy-on-write is written to swap only once.
+//	"sharedSlot" is the slot an earlier page mapping the same frame
+//	was saved to, or -1; the page takes a share of it instead of
+//	writing its own.  A page whose own slot is shared never writes
+//	to it, since that would change the other holders' pages too; it
+//	gets a fresh one.
+//
+//	The page is marked invalid before any I/O is started, so that a
+//	thread touching it in the meantime faults, and waits on
+//	pagingLock until the page is safely out.
+//
+//	Returns the slot the frame was saved to, for the next page
+//	mapping it: "sharedSlot", or the one written now.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::EvictPage(int vpn, int sharedSlot)
+{
+    TranslationEntry *entry = &KernelPageTable[vpn];
+    int frame = entry->physicalPage;
+    FileMapping *m;
+    int offset;
+
+    ASSERT(pagingLock->isHeldByCurrentThread());
+    ASSERT(entry->valid);
+    FlushTLB();
+    coreMap->UnmapFrame(frame, this, vpn);
+    entry->valid = FALSE;
+    CountResident(-1);
+    if (entry->dirty && ((unsigned) vpn >= numImagePages)) {
+	m = FindMapping(vpn);
+	offset = (vpn - m->firstPage) * PageSize;
+	DEBUG('v', "Evicting page %d: writing back %s:%d from frame %d\n",
+	      vpn, m->fileName, offset, frame);
+	m->file->WriteAt(&(machine->mainMemory[frame * PageSize]),
+			 min(PageSize, m->length - offset), offset);
+	stats->numPageOuts++;
+	numPageOuts++;
+    } else if (entry->dirty && (sharedSlot != -1)) {
+	DEBUG('v', "Evicting page %d: sharing swap slot %d\n", vpn,
+	      sharedSlot);
+	if (swapSlots[vpn] != -1)
+	    swapSpace->FreeSlot(swapSlots[vpn]);
+	swapSpace->ShareSlot(sharedSlot);
+	swapSlots[vpn] = sharedSlot;
+    } else if (entry->dirty) {
+	if ((swapSlots[vpn] != -1) && swapSpace->IsShared(swapSlots[vpn])) {
+	    swapSpace->FreeSlot(swapSlots[vpn]);
+	    swapSlots[vpn] = -1;
+	}
+	if (swapSlots[vpn] == -1)
+	    swapSlots[vpn] = swapSpace->AllocateSlot();
+	ASSERT(swapSlots[vpn] != -1);	// out of swap space
+	DEBUG('v', "Evicting page %d: frame %d to swap slot %d\n",
+	      vpn, frame, swapSlots[vpn]);
+	swapSpace->WritePage(swapSlots[vpn], frame);
+	sharedSlot = swapSlots[vpn];
+	stats->numPageOuts++;
+	numPageOuts++;
+    } else
+	DEBUG('v', "Evicting clean page %d from frame %d\n", vpn, frame);
+    entry->dirty = FALSE;
+    entry->readOnly = FALSE;
+    copyOnWrite[vpn] = FALSE;
+    ReleaseFrame(frame);
+    return sharedSlot;
+}
+#endif
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::SyncTLB
+// 	If the machine has a TLB and it holds our translations, copy the
+//	use and dirty bits the hardware set in it back into the page
+//	table, where the replacement policy and EvictPage look for them.
+//	Use bits are cleared in the TLB as they are copied, so that a
+//	policy clearing them in the page table isn't undone by the next
+//	sync.  A large page entry has only one set of bits, so they are
+//	copied to every page it covers.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::SyncTLB()
+{
+    TranslationEntry *tlbEntry;
+    int i, j;
+
+    if ((machine->tlb == NULL) || (scheduler->ActiveAddressSpace() != this))
+	return;
+    for (i = 0; i < TLBSize; i++) {
+	tlbEntry = &machine->tlb[i];
+	if (!tlbEntry->valid)
+	    continue;
+	for (j = 0; j < tlbEntry->numPages; j++) {
+	    if (tlbEntry->use)
+		KernelPageTable[tlbEntry->virtualPage + j].use = TRUE;
+	    if (tlbEntry->dirty)
+		KernelPageTable[tlbEntry->virtualPage + j].dirty = TRUE;
+	}
+	tlbEntry->use = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::FlushTLB
+// 	Sync the TLB with the page table, and then empty it, because
+//	our translations are about to change.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::FlushTLB()
+{
+    int i;
+
+    if ((machine->tlb == NULL) || (scheduler->ActiveAddressSpace() != this))
+	return;
+    SyncTLB();
+    for (i = 0; i < TLBSize; i++)
+	machine->tlb[i].valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::LoadTLB
+// 	Put the translation for page "vpn" in the TLB, in a free entry
+//	if there is one, or else in place of the next entry round.  If
+//	"vpn" is part of a large page that is still intact, one entry
+//	covering the whole large page goes in instead, replacing any
+//	entries for its pages.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::LoadTLB(int vpn)
+{
+    TranslationEntry *tlbEntry;
+    int i, slot;
+    int first = vpn - vpn % largePagePages;
+
+    if ((machine->tlb == NULL) || (scheduler->ActiveAddressSpace() != this))
+	return;
+    if (!IsLargePage(first))
+	first = -1;
+    else
+	for (i = 0; i < TLBSize; i++) {
+	    tlbEntry = &machine->tlb[i];
+	    if (tlbEntry->valid && (tlbEntry->virtualPage >= first)
+		    && (tlbEntry->virtualPage < first + largePagePages)) {
+		SyncTLB();
+		tlbEntry->valid = FALSE;
+	    }
+	}
+    slot = ChooseTLBSlot();
+    if (first == -1)
+	machine->tlb[slot] = KernelPageTable[vpn];
+    else {
+	machine->tlb[slot] = KernelPageTable[first];
+	machine->tlb[slot].numPages = largePagePages;
+	machine->tlb[slot].use = FALSE;
+	machine->tlb[slot].dirty = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ChooseTLBSlot
+// 	Return a TLB entry to load a translation into: a free one if
+//	there is one, or else the next one round, whose use and dirty
+//	bits are saved first.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::ChooseTLBSlot()
+{
+    int i, slot;
+
+    for (i = 0; i < TLBSize; i++)
+	if (!machine->tlb[i].valid)
+	    return i;
+    SyncTLB();
+    slot = nextTLBSlot;
+    nextTLBSlot = (nextTLBSlot + 1) % TLBSize;
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::IsLargePage
+// 	Return TRUE if the large page starting at virtual page "first"
+//	is mapped as one: every page of it valid, held in consecutive
+//	frames starting at a multiple of largePagePages, and with the
+//	same protection.  A large page stops being one as soon as any
+//	of its pages is evicted, or given a copy of its own on a write.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::IsLargePage(int first)
+{
+    TranslationEntry *base = &KernelPageTable[first];
+    int i;
+
+    if ((largePagePages == 1) || (first + largePagePages > (int) numImagePages)
+		|| !base->valid || (base->physicalPage % largePagePages != 0))
+	return FALSE;
+    for (i = 1; i < largePagePages; i++)
+	if (!KernelPageTable[first + i].valid
+		|| (KernelPageTable[first + i].physicalPage
+			!= base->physicalPage + i)
+		|| (KernelPageTable[first + i].readOnly != base->readOnly))
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::LoadLargePage
+// 	Try to bring in the whole large page containing virtual page
+//	"vpn", in one run of frames, so that a single TLB entry can map
+//	it.  Only the program's code and data are put in large pages,
+//	and only where none of the pages has been brought in before.
+//	The pages are private to this address space, even those holding
+//	nothing but code.  There is no eviction to make room: if there
+//	is no free run of frames, the caller just loads the one page.
+//
+//	The page table still has an entry per page, so without a TLB
+//	a large page would buy nothing; -largepages is only accepted in
+//	builds with one.
+//
+//	Returns TRUE if the large page was loaded.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::LoadLargePage(int vpn)
+{
+    int first = vpn - vpn % largePagePages;
+    int dataEnd = max(noffH.code.virtualAddr + noffH.code.size,
+		max(noffH.initData.virtualAddr + noffH.initData.size,
+		    noffH.uninitData.virtualAddr + noffH.uninitData.size));
+    int i, frame;
+
+    if ((largePagePages == 1)
+		|| ((first + largePagePages) * PageSize > dataEnd))
+	return FALSE;
+    for (i = first; i < first + largePagePages; i++) {
+	if (KernelPageTable[i].valid || checkpointed[i])
+	    return FALSE;
+#ifdef VM
+	if (swapSlots[i] != -1)
+	    return FALSE;
+#endif
+    }
+    frame = frameAllocator->AllocateFrames(largePagePages);
+    if (frame == -1)
+	return FALSE;
+
+    DEBUG('a', "Page fault at page %d, loading large page %d-%d into "
+	  "frames %d-%d\n", vpn, first, first + largePagePages - 1, frame,
+	  frame + largePagePages - 1);
+    for (i = 0; i < largePagePages; i++) {
+	KernelPageTable[first + i].physicalPage = frame + i;
+	CopyInSegment(&noffH.code, first + i);
+	CopyInSegment(&noffH.initData, first + i);
+	KernelPageTable[first + i].valid = TRUE;
+	CountResident(1);
+	KernelPageTable[first + i].use = FALSE;
+	KernelPageTable[first + i].dirty = FALSE;
+	KernelPageTable[first + i].readOnly = FALSE;
+	copyOnWrite[first + i] = FALSE;
+#ifdef VM
+	coreMap->MapFrame(frame + i, this, first + i);
+#endif
+    }
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -132,7 +1791,7 @@ ProcessAddressSpace::~ProcessAddressSpace()
 // 	We write these directly into the "machine" registers, so
 //	that we can immediately jump to user code.  Note that these
 //	will be saved/restored into the currentThread->userRegisters
-//	when this thread is context switched out.
+//	when another user thread needs the machine registers.
 //----------------------------------------------------------------------
 
 void
@@ -140,6 +1799,8 @@ ProcessAddressSpace::InitUserModeCPURegisters()
 {
     int i;
 
+    scheduler->ClaimUserRegisters(currentThread);	// we're about to
+						// overwrite the registers
     for (i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, 0);
 
@@ -157,16 +1818,357 @@ ProcessAddressSpace::InitUserModeCPURegisters()
     DEBUG('a', "Initializing stack register to %d\n", numVirtualPages * PageSize - 16);
 }
 
+//----------------------------------------------------------------------
+// ProcessAddressSpace::RestoreUserModeCPURegisters
+// 	Set the user-level register set to "registers", NumTotalRegs of
+//	them, saved by a checkpoint.  Like InitUserModeCPURegisters, they
+//	go straight into the machine.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::RestoreUserModeCPURegisters(int *registers)
+{
+    int i;
+
+    scheduler->ClaimUserRegisters(currentThread);
+    for (i = 0; i < NumTotalRegs; i++)
+	machine->WriteRegister(i, registers[i]);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::Checkpoint
+// 	Save enough of the process in the file "fileName" for it to
+//	carry on later, after Nachos has been restarted if need be: the
+//	layout of the address space, its open and mapped files, the user
+//	"registers" (NumTotalRegs of them), and every page that has been
+//	written to.  The other pages can be loaded from the executable or
+//	mapped file again, so they are left out.  The checkpoint
+//	constructor is the way back.
+//
+//	Each saved page is made read-only, so that HandleReadOnlyFault
+//	sees the first write to it.  So if the last checkpoint went to
+//	the same file, and the address space hasn't grown since, only
+//	the pages written since then need saving; the others are still
+//	in the file.  A checkpoint then costs time in proportion to the
+//	pages the process has dirtied, not to its size.  Otherwise the
+//	file is started afresh.
+//
+//	The pages start where the last checkpoint to the file put them,
+//	if the header still fits in front of them; a header that has
+//	grown, with more files open, starts the file afresh too.
+//
+//	Returns the number of pages written, or -1 if the file can't be
+//	created, or a file name is too long to record.  With the Nachos
+//	file system, a checkpoint bigger than the largest file it can
+//	hold is refused too.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::Checkpoint(char *fileName, int *registers)
+{
+    CheckpointHeader *header = new CheckpointHeader;
+    int dataOffset;
+    OpenFile *file = NULL;
+    bool fresh = FALSE;
+    char *page, *saved;
+    unsigned int vpn;
+    int written = 0;
+
+    if ((strlen(fileName) >= CheckpointNameLength)
+		|| !FillCheckpointHeader(header, registers)) {
+	delete header;
+	return -1;
+    }
+    dataOffset = CheckpointDataOffset(header);
+    if ((checkpointName != NULL) && !strcmp(checkpointName, fileName)
+		&& (checkpointPages == numVirtualPages)
+		&& (dataOffset <= checkpointDataOffset)) {
+	dataOffset = checkpointDataOffset;
+	file = fileSystem->Open(fileName);
+    }
+    if (file == NULL) {
+	fresh = TRUE;
+	dataOffset = CheckpointDataOffset(header);
+#ifdef FILESYS
+	if (dataOffset + (int) numVirtualPages * PageSize
+		> (int) MaxFileSize) {
+	    DEBUG('a', "Checkpoint to %s: too big for a file\n", fileName);
+	    delete header;
+	    return -1;
+	}
+#endif
+	fileSystem->Remove(fileName);
+	if (fileSystem->Create(fileName,
+			       dataOffset + numVirtualPages * PageSize))
+	    file = fileSystem->Open(fileName);
+	if (file == NULL) {
+	    delete header;
+	    return -1;
+	}
+    }
+
+    page = new char[PageSize];
+    pagingLock->Acquire();
+    FlushTLB();				// pick up the dirty bits
+    for (vpn = 0; vpn < numVirtualPages; vpn++) {
+	if (fresh && checkpointed[vpn] && !IsModified(vpn)) {
+	    checkpointed[vpn] = FALSE;	// written back to its mapped
+	    if (!copyOnWrite[vpn])	// file since the last checkpoint
+		KernelPageTable[vpn].readOnly = FALSE;
+	}
+	if (!IsModified(vpn) || (checkpointed[vpn] && !fresh))
+	    continue;
+	if (KernelPageTable[vpn].valid)
+	    file->WriteAt(&(machine->mainMemory[
+				KernelPageTable[vpn].physicalPage * PageSize]),
+			  PageSize, dataOffset + vpn * PageSize);
+#ifdef VM
+	else {
+	    swapSpace->ReadSlot(swapSlots[vpn], page);
+	    file->WriteAt(page, PageSize, dataOffset + vpn * PageSize);
+	}
+#endif
+	checkpointed[vpn] = TRUE;
+	written++;
+	if (KernelPageTable[vpn].valid)
+	    KernelPageTable[vpn].readOnly = TRUE;
+    }
+    saved = new char[numVirtualPages];
+    for (vpn = 0; vpn < numVirtualPages; vpn++)
+	saved[vpn] = checkpointed[vpn];
+    header->dataOffset = dataOffset;
+    file->WriteAt(saved, numVirtualPages, dataOffset - numVirtualPages);
+    WriteCheckpointHeader(file, header);
+    pagingLock->Release();
+
+    DEBUG('a', "Checkpoint to %s: %d pages written%s\n", fileName,
+	  written, fresh ? ", from scratch" : "");
+    if (fresh) {
+	delete [] checkpointName;
+	checkpointName = new char[strlen(fileName) + 1];
+	strcpy(checkpointName, fileName);
+	checkpointPages = numVirtualPages;
+	checkpointDataOffset = dataOffset;
+    }
+    stats->numCheckpoints++;
+    stats->numCheckpointPages += written;
+    delete [] saved;
+    delete [] page;
+    delete file;
+    delete header;
+    return written;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::FillCheckpointHeader
+// 	Describe this address space in "header", for a checkpoint, with
+//	"registers" as the user registers to resume with.
+//
+//	Returns FALSE if the name of the executable, or of an open or
+//	mapped file, is too long to record.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::FillCheckpointHeader(CheckpointHeader *header,
+					  int *registers)
+{
+    CheckpointFile *f;
+    CheckpointMapping *cm;
+    FileMapping *m;
+    int i;
+
+    bzero((char *) header, sizeof(CheckpointHeader));
+    header->magic = CheckpointMagic;
+    header->pageSize = PageSize;
+    header->numVirtualPages = numVirtualPages;
+    header->numImagePages = numImagePages;
+    header->syscallRing = syscallRing;
+    for (i = 0; i < NumTotalRegs; i++)
+	header->registers[i] = registers[i];
+    header->executableName = AddName(header, executableName);
+    if (header->executableName == -1)
+	return FALSE;
+    for (i = 0; i < MaxOpenFiles; i++) {
+	if (openFiles[i] == NULL)
+	    continue;
+	f = &header->files[header->numFiles++];
+	f->id = i;
+	f->position = openFiles[i]->Position();
+	f->name = AddName(header, openFileNames[i]);
+	if (f->name == -1)
+	    return FALSE;
+    }
+    for (i = 0; i < MaxFileMappings; i++) {
+	m = &mappings[i];
+	if (m->firstPage == -1)
+	    continue;
+	cm = &header->mappings[header->numMappings++];
+	cm->firstPage = m->firstPage;
+	cm->numPages = m->numPages;
+	cm->length = m->length;
+	cm->name = AddName(header, m->fileName);
+	if (cm->name == -1)
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CountResident
+// 	Note that "delta" pages came into (or, if negative, left) memory,
+//	keeping track of the most there have ever been.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::CountResident(int delta)
+{
+    numResident += delta;
+    if (numResident > peakResident)
+	peakResident = numResident;
+}
+
+#ifdef VM
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ProtectPage
+// 	Make page "vpn", which is in memory, copy-on-write, because its
+//	frame is about to be shared.  The caller holds pagingLock.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::ProtectPage(int vpn)
+{
+    ASSERT(pagingLock->isHeldByCurrentThread());
+    ASSERT(KernelPageTable[vpn].valid);
+    FlushTLB();
+    KernelPageTable[vpn].readOnly = TRUE;
+    copyOnWrite[vpn] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::RemapPage
+// 	Give up the frame holding page "vpn", and map "frame" instead,
+//	copy-on-write.  The caller (the page merger) has checked that
+//	"frame" holds the same contents.  The page stays as dirty as it
+//	was, since its contents haven't changed.  The caller holds
+//	pagingLock.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::RemapPage(int vpn, int frame)
+{
+    ASSERT(pagingLock->isHeldByCurrentThread());
+    ASSERT(KernelPageTable[vpn].valid);
+    FlushTLB();
+    DropFrame(vpn);
+    frameAllocator->ShareFrame(frame);
+    coreMap->MapFrame(frame, this, vpn);
+    KernelPageTable[vpn].physicalPage = frame;
+    KernelPageTable[vpn].readOnly = TRUE;
+    copyOnWrite[vpn] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::LastUse
+// 	Return when page "vpn" was last seen in use.  If its use bit is
+//	set, it has been used since the last look, so note the time and
+//	clear the bit.  Pages never seen in use were last used long
+//	enough ago to be outside any working set.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::LastUse(int vpn)
+{
+    if (KernelPageTable[vpn].use) {
+	lastUses[vpn] = stats->totalTicks;
+	KernelPageTable[vpn].use = FALSE;
+    }
+    return lastUses[vpn];
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::WorkingSetSize
+// 	Estimate the working set of this address space: the number of
+//	pages in memory that were used within the last WorkingSetWindow
+//	ticks.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::WorkingSetSize()
+{
+    unsigned int i;
+    int size = 0;
+
+    SyncTLB();
+    for (i = 0; i < numVirtualPages; i++)
+	if (KernelPageTable[i].valid
+		&& (stats->totalTicks - LastUse(i) <= WorkingSetWindow))
+	    size++;
+    return size;
+}
+#endif
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::GetMemStats
+// 	Fill in "values", which has room for MemStatSize ints, with this
+//	address space's memory usage, in the layout given by MemStat_*
+//	in syscall.h.  Pages shared with other processes count in full
+//	for each of them.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::GetMemStats(int *values)
+{
+    int swapPages = 0;
+#ifdef VM
+    unsigned int i;
+
+    for (i = 0; i < numVirtualPages; i++)
+	if (swapSlots[i] != -1)
+	    swapPages++;
+#endif
+    values[MemStat_PageSize] = PageSize;
+    values[MemStat_VirtualPages] = numVirtualPages;
+    values[MemStat_ResidentPages] = numResident;
+    values[MemStat_PeakResident] = peakResident;
+    values[MemStat_SwapPages] = swapPages;
+    values[MemStat_PageFaults] = numPageFaults;
+    values[MemStat_PageIns] = numPageIns;
+    values[MemStat_PageOuts] = numPageOuts;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::PrintMemStats
+// 	Print a summary of this address space's memory usage, for
+//	process "pid", which is about to exit.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::PrintMemStats(int pid)
+{
+    int values[MemStatSize];
+
+    GetMemStats(values);
+    printf("Process %d memory: virtual %d pages, resident %d (peak %d), "
+	   "swap %d, faults %d, page ins %d, page outs %d\n", pid,
+	   values[MemStat_VirtualPages], values[MemStat_ResidentPages],
+	   values[MemStat_PeakResident], values[MemStat_SwapPages],
+	   values[MemStat_PageFaults], values[MemStat_PageIns],
+	   values[MemStat_PageOuts]);
+}
+
 //----------------------------------------------------------------------
 // ProcessAddressSpace::SaveContextOnSwitch
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	If there is a TLB, write its use and dirty bits back to the
+//	page table and empty it.
 //----------------------------------------------------------------------
 
 void ProcessAddressSpace::SaveContextOnSwitch() 
-{}
+{
+    FlushTLB();
+}
 
 //----------------------------------------------------------------------
 // ProcessAddressSpace::RestoreContextOnSwitch
@@ -174,10 +2176,20 @@ void ProcessAddressSpace::SaveContextOnSwitch()
 //	this address space can run.
 //
 //      For now, tell the machine where to find the page table.
+//	If there is a TLB, the machine can't use a page table at the
+//	same time, so just make sure the TLB starts out empty; it is
+//	filled in on demand by HandlePageFault.
 //----------------------------------------------------------------------
 
 void ProcessAddressSpace::RestoreContextOnSwitch() 
 {
+    int i;
+
+    if (machine->tlb != NULL) {
+	for (i = 0; i < TLBSize; i++)
+	    machine->tlb[i].valid = FALSE;
+	return;
+    }
     machine->KernelPageTable = KernelPageTable;
     machine->pageTableSize = numVirtualPages;
 }
@@ -15,27 +15,225 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "noff.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
+#define MaxOpenFiles		16	// open files per process, counting
+					// ConsoleInput and ConsoleOutput
+#define MaxFileMappings		8	// mapped files per process
+
+// A file mapped into an address space by Mmap.  Its pages are read in
+// from the file on first touch, and written back, if dirty, when the
+// mapping goes away.
+
+struct FileMapping {
+    int firstPage;			// First virtual page, or -1 if unused
+    int numPages;			// Pages in the mapping
+    int length;				// Bytes of the file that are mapped
+    OpenFile *file;			// The file, opened just for the mapping
+    char *fileName;			// ... and its name
+};
+
+struct CheckpointHeader;		// See Checkpoint in addrspace.cc
+
+// What became of a fault, as HandlePageFault and HandleReadOnlyFault
+// report it.
+
+enum FaultResult {
+    FaultHandled,			// the access can be tried again
+    FaultBadAddress,			// not part of the address space, or
+					// written to but read-only
+    FaultNoMemory			// no frame could be found for it
+};
+
 class ProcessAddressSpace {
   public:
-    ProcessAddressSpace(OpenFile *executable);	// Create an address space,
-					// initializing it with the program
-					// stored in the file "executable"
+    ProcessAddressSpace(OpenFile *executableFile, char *fileName);
+					// Create an address space for the
+					// program stored in the file
+					// "executableFile", opened from
+					// "fileName"; the space takes
+					// ownership of the file
+    ProcessAddressSpace(ProcessAddressSpace *parent);
+					// Create a copy-on-write duplicate
+					// of "parent", for Fork
     ~ProcessAddressSpace();			// De-allocate an address space
 
+    static ProcessAddressSpace *Restore(OpenFile *checkpoint,
+					char *fileName, int *registers);
+					// Recreate the address space saved
+					// in "checkpoint", opened from
+					// "fileName", putting the saved
+					// user registers in "registers";
+					// NULL if it can't be restored
+    bool RestorePages(OpenFile *checkpoint);
+					// ... and then read its saved pages
+					// back in; FALSE if they don't fit
+    static int CountImagePages(OpenFile *executableFile);
+					// Pages the program in
+					// "executableFile" needs; -1 if it
+					// can't be run
+
     void InitUserModeCPURegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
+    void RestoreUserModeCPURegisters(int *registers);
+					// ... or set them to "registers"
+
+    int Checkpoint(char *fileName, int *registers);
+					// Save the address space, its file
+					// table and the user "registers"
+					// to "fileName"; returns the number
+					// of pages written, or -1
+
+    FaultResult HandlePageFault(int virtAddr);
+					// Bring in the page containing
+					// "virtAddr"
+    FaultResult HandleReadOnlyFault(int virtAddr);
+					// Give the page containing
+					// "virtAddr" a private copy of a
+					// shared frame
+
+    int AddOpenFile(OpenFile *file, char *fileName);
+					// Enter an open file in the file
+					// table; returns its OpenFileId, or
+					// -1 if the table is full
+    OpenFile *GetOpenFile(int id);	// The open file "id", or NULL
+    bool CloseFile(int id);		// Remove "id" from the file table
+					// and close it
+
+    int MapFile(int id, int length);	// Map the first "length" bytes of
+					// open file "id" into the address
+					// space; returns the address
+    bool UnmapFile(int virtAddr);	// Undo the mapping at "virtAddr",
+					// writing dirty pages back
+
+    bool IsWritable(int virtAddr, int size);
+					// May the program write all "size"
+					// bytes at "virtAddr"?
+
+    void SetSyscallRing(int virtAddr) { syscallRing = virtAddr; }
+    int GetSyscallRing() { return syscallRing; }
+					// Address of the system call ring,
+					// or -1 if none is registered
+
+    TranslationEntry *GetPageTableEntry(int vpn)
+				{ return &KernelPageTable[vpn]; }
+
+    void GetMemStats(int *values);	// Fill in the MemStat_* values of
+					// syscall.h
+    void PrintMemStats(int pid);	// Print them, when process "pid"
+					// exits
+#ifdef VM
+    int EvictPage(int vpn, int sharedSlot);
+					// Write page "vpn" out if it is
+					// dirty, and let go of its frame;
+					// the caller holds pagingLock
+    void ProtectPage(int vpn);		// Make page "vpn" copy-on-write
+    void RemapPage(int vpn, int frame);	// Share "frame", which has the
+					// same contents, for page "vpn"
+    int LastUse(int vpn);		// When page "vpn" was last used
+    int WorkingSetSize();		// Pages used in the last
+					// WorkingSetWindow ticks
+#endif
 
     void SaveContextOnSwitch();			// Save/restore address space-specific
     void RestoreContextOnSwitch();		// info on a context switch 
 
+    static int NumSpaces() { return numSpaces; }
+					// Number of address spaces (that is,
+					// user processes) in existence
+
   private:
     TranslationEntry *KernelPageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numVirtualPages;		// Number of pages in the virtual 
 					// address space
+    unsigned int numImagePages;		// How many of them hold the program
+					// and its stack; mappings go after
+    static int numSpaces;		// Number of address spaces alive
+    OpenFile *executable;		// Where to fetch code and data pages
+					// from on first touch
+    char *executableName;		// ... and its name, so a forked
+					// child can open its own copy
+    NoffHeader noffH;			// Segment layout of "executable"
+    bool *copyOnWrite;			// For each page, TRUE if it is only
+					// read-only because its frame is
+					// shared with a parent or child
+#ifdef VM
+    int *swapSlots;			// For each page, the swap slot
+					// holding its contents, or -1
+    int *lastUses;			// For each page, when it was last
+					// seen in use; see LastUse
+#endif
+
+    OpenFile *openFiles[MaxOpenFiles];	// Files opened by the program
+    char *openFileNames[MaxOpenFiles];	// ... and their names
+    FileMapping mappings[MaxFileMappings];	// Files mapped into memory
+    int syscallRing;			// See RingSetup in syscall.h
+
+    int numResident;			// Pages in memory now
+    int peakResident;			// ... and at most, so far
+    int numPageFaults;			// Faults that brought a page in
+    int numPageIns;			// ... of them, from swap
+    int numPageOuts;			// Dirty pages written out on eviction
+
+    bool *checkpointed;			// For each page, TRUE if its
+					// contents are saved in the last
+					// checkpoint; see Checkpoint
+    char *checkpointName;		// File of the last checkpoint, or
+					// NULL
+    unsigned int checkpointPages;	// ... and numVirtualPages then
+    int checkpointDataOffset;		// ... and where its pages start
+
+    int faultAroundWindow;		// Pages to bring in after the next
+					// fault, if it is sequential
+    int nextSequentialPage;		// Page a sequential fault would be at
+
+    ProcessAddressSpace(CheckpointHeader *header, OpenFile *executableFile,
+			OpenFile **mappedFiles, char *fileName);
+					// The work of Restore, once it has
+					// checked the checkpoint
+    void InitImage(OpenFile *executableFile, char *fileName);
+					// Set up the address space of the
+					// program in "executableFile"
+    bool IsTextPage(int vpn);		// Is page "vpn" nothing but code?
+    bool IsModified(int vpn);		// Has page "vpn" been written to
+					// since it was loaded?
+    bool FillCheckpointHeader(CheckpointHeader *header, int *registers);
+					// Describe the address space for
+					// a checkpoint; FALSE if a name
+					// is too long to record
+    void CopyInSegment(Segment *segment, int vpn);
+					// Read the part of "segment" that
+					// falls in page "vpn" into its frame
+    FileMapping *FindMapping(int vpn);	// The mapping page "vpn" belongs to
+    void ResizePageTable(unsigned int newSize);
+					// Add invalid pages to the end of
+					// the address space, or cut them off
+    int FindFreePages(int numPages);	// Where "numPages" pages could be
+					// mapped
+    void InitFileTables(ProcessAddressSpace *parent);
+					// Set up the file table and mappings,
+					// copying those of "parent" if any
+    int GetFrame();			// Allocate a frame, evicting one if
+					// memory is full; -1 if none can be
+    void DropFrame(int vpn);		// Let go of page "vpn"'s frame
+    void CountResident(int delta);	// "delta" more pages in memory
+    int FaultAround(int vpn, FileMapping *m);
+					// Bring in pages following "vpn"
+    bool CanFaultAround(int vpn, FileMapping *m);
+					// May page "vpn" be brought in so?
+
+    void SyncTLB();			// Copy use and dirty bits from the
+					// TLB into the page table
+    void FlushTLB();			// ... and empty the TLB
+    int ChooseTLBSlot();		// Free a TLB entry to load into
+    void LoadTLB(int vpn);		// Put page "vpn" in the TLB
+    bool IsLargePage(int first);	// Is the large page at "first"
+					// mapped by consecutive frames?
+    bool LoadLargePage(int vpn);	// Bring in the whole large page
+					// around "vpn", if possible
 };
 
 #endif // ADDRSPACE_H
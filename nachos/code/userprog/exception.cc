@@ -4,8 +4,8 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  Each system call has a handler, found by
+//	looking up the system call code in a table.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +14,9 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Page faults and writes to copy-on-write pages are serviced, and a
+// process that faults when no frame can be found for it is killed;
+// everything else core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -24,8 +25,695 @@
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
-#include "console.h"
-#include "synch.h"
+#include "synchconsole.h"
+#include <stddef.h>
+
+//----------------------------------------------------------------------
+// ReadUserMem, WriteUserMem
+// 	Kernel access to user memory.  Pages are brought in on demand,
+//	so the first touch of a page traps into ExceptionHandler like a
+//	user access would; once the fault is serviced, just try again.
+//	The nested trap returns in user mode, so switch back to system
+//	mode before carrying on.
+//----------------------------------------------------------------------
+
+static void
+ReadUserMem (int vaddr, int size, int *value)
+{
+   while (!machine->ReadMem(vaddr, size, value))
+      interrupt->setStatus(SystemMode);
+}
+
+static void
+WriteUserMem (int vaddr, int size, int value)
+{
+   while (!machine->WriteMem(vaddr, size, value))
+      interrupt->setStatus(SystemMode);
+}
+
+//----------------------------------------------------------------------
+// ReadUserString
+// 	Copy a null-terminated string out of user memory at "vaddr" into
+//	"buf", which has room for "size" bytes.  The copy is truncated
+//	(but still null-terminated) if the string is too long.
+//----------------------------------------------------------------------
+
+#define MaxFileNameLength	100
+
+static void
+ReadUserString (int vaddr, char *buf, int size)
+{
+   int memval, i;
+
+   for (i = 0; i < size - 1; i++) {
+      ReadUserMem(vaddr + i, 1, &memval);
+      buf[i] = (char) memval;
+      if (buf[i] == '\0') return;
+   }
+   buf[i] = '\0';
+}
+
+//----------------------------------------------------------------------
+// WriteUserConsole
+// 	Queue "size" bytes of user memory at "vaddr" for console output.
+//	The bytes are copied into the kernel a chunk at a time, and each
+//	chunk goes to the console in one piece.  If "size" is negative,
+//	copy up to the first null byte instead.
+//----------------------------------------------------------------------
+
+#define ConsoleChunkSize	128
+
+static void
+WriteUserConsole (int vaddr, int size)
+{
+   char buf[ConsoleChunkSize];
+   int memval, n;
+
+   while (size != 0) {
+      for (n = 0; (n < ConsoleChunkSize) && (size != 0); n++, size--) {
+	 ReadUserMem(vaddr + n, 1, &memval);
+	 if ((size < 0) && ((char) memval == '\0')) {
+	    size = 0;
+	    break;
+	 }
+	 buf[n] = (char) memval;
+      }
+      synchConsole->Write(buf, n);
+      vaddr += n;
+   }
+}
+
+//----------------------------------------------------------------------
+// ForkStartFunction
+// 	First thing run by the thread created for a forked child: pick
+//	up the user registers and address space set up by the Fork
+//	system call, and start running the child's copy of the program.
+//----------------------------------------------------------------------
+
+static void
+ForkStartFunction (int dummy)
+{
+#ifdef VM
+   if (loadControl != NULL)
+      loadControl->Admit(currentThread->space);
+#endif
+   scheduler->LoadUserRegisters(currentThread);
+   scheduler->ActivateAddressSpace(currentThread->space);
+   machine->Run();
+   ASSERT(FALSE);		// machine->Run never returns
+}
+
+//----------------------------------------------------------------------
+// CopySchedStats
+// 	Copy the scheduler statistics out to the user buffer at "vaddr",
+//	which has room for "size" ints, in the layout given by SchedStat_*
+//	in syscall.h.  Returns the number of ints copied.
+//----------------------------------------------------------------------
+
+static int
+CopySchedStats (int vaddr, int size)
+{
+   int values[SchedStatSize];
+   int i;
+
+   ASSERT(NumHistBuckets == SchedStatBuckets);
+   values[SchedStat_Dispatches] = stats->numDispatches;
+   values[SchedStat_Voluntary] = stats->numVoluntarySwitches;
+   values[SchedStat_Involuntary] = stats->numInvoluntarySwitches;
+   values[SchedStat_TotalTicks] = stats->totalTicks;
+   values[SchedStat_MyWaitTicks] = currentThread->waitTicks;
+   values[SchedStat_MyRunTicks] = currentThread->runTicks
+			+ (stats->totalTicks - currentThread->runningSince);
+   values[SchedStat_MyVoluntary] = currentThread->voluntarySwitches;
+   values[SchedStat_MyInvoluntary] = currentThread->involuntarySwitches;
+   for (i = 0; i < SchedStatBuckets; i++) {
+      values[SchedStat_WaitHistogram + i] = stats->readyWaitTicks.buckets[i];
+      values[SchedStat_RunHistogram + i] = stats->runTicks.buckets[i];
+   }
+
+   if (size > SchedStatSize) size = SchedStatSize;
+   for (i = 0; i < size; i++)
+      WriteUserMem(vaddr + 4*i, 4, values[i]);
+   return (size > 0) ? size : 0;
+}
+
+//----------------------------------------------------------------------
+// ReadUser, WriteUser
+// 	The work of the Read and Write system calls, shared with the
+//	system call ring: move "size" bytes between user memory at
+//	"vaddr" and the open file "id" (or the console), a buffer at a
+//	time.  Return the number of bytes moved, or -1 if "id" isn't
+//	open or "size" is negative.
+//----------------------------------------------------------------------
+
+static int
+ReadUser (int vaddr, int size, int id)
+{
+   char buf[ConsoleBufferSize];
+   OpenFile *file = currentThread->space->GetOpenFile(id);
+   int i, n, total = 0;
+
+   if (((id != ConsoleInput) && (file == NULL)) || (size < 0))
+      return -1;
+   if (id == ConsoleInput) {
+      if (size > ConsoleBufferSize)	// no line is longer than that
+	 size = ConsoleBufferSize;
+      total = synchConsole->Read(buf, size);
+      for (i = 0; i < total; i++)
+	 WriteUserMem(vaddr + i, 1, buf[i]);
+   }
+   else {
+      while (total < size) {
+	 n = file->Read(buf, min(size - total, ConsoleBufferSize));
+	 for (i = 0; i < n; i++)
+	    WriteUserMem(vaddr + total + i, 1, buf[i]);
+	 total += n;
+	 if (n < ConsoleBufferSize)	// end of file
+	    break;
+      }
+   }
+   return total;
+}
+
+static int
+WriteUser (int vaddr, int size, int id)
+{
+   char buf[ConsoleChunkSize];
+   OpenFile *file = currentThread->space->GetOpenFile(id);
+   int memval, i, n, total;
+
+   if (((id != ConsoleOutput) && (file == NULL)) || (size < 0))
+      return -1;
+   if (id == ConsoleOutput) {
+      WriteUserConsole(vaddr, size);
+      return size;
+   }
+   for (total = 0; total < size; total += n) {
+      n = min(size - total, ConsoleChunkSize);
+      for (i = 0; i < n; i++) {
+	 ReadUserMem(vaddr + total + i, 1, &memval);
+	 buf[i] = (char) memval;
+      }
+      file->Write(buf, n);
+   }
+   return total;
+}
+
+//----------------------------------------------------------------------
+// DrainSyscallRing
+// 	Carry out the requests waiting in the calling process's system
+//	call ring, if it has one, posting a completion for each (see
+//	RingSetup in syscall.h for the layout).  Each request is taken
+//	off the ring before it is carried out, and the counters are
+//	read afresh each time round, so the program (or, after a Yield,
+//	another of its threads) can keep adding requests while we work.
+//	Stops early when the completion half of the ring is full.
+//
+//	The ring is checked afresh each time round as well: it was
+//	writable when it was registered, but a Restore may have brought
+//	back a bad one.  A ring that isn't writable is dropped.
+//
+//	Returns the number of requests carried out, or -1 if the ring
+//	had to be dropped.
+//----------------------------------------------------------------------
+
+#define RingField(ring, field)	((ring) + (int) offsetof(SyscallRing, field))
+
+static int
+DrainSyscallRing ()
+{
+   ProcessAddressSpace *space = currentThread->space;
+   int ring, submitHead, submitTail, completionHead, completionTail;
+   int request, completion, code, arg1, arg2, arg3, tag, result;
+   int done = 0;
+
+   for (;;) {
+      ring = space->GetSyscallRing();
+      if (ring == -1)
+	 break;
+      if (!space->IsWritable(ring, sizeof(SyscallRing))) {
+	 DEBUG('a', "Dropping bad system call ring at 0x%x\n", ring);
+	 space->SetSyscallRing(-1);
+	 return -1;
+      }
+      ReadUserMem(RingField(ring, submitHead), 4, &submitHead);
+      ReadUserMem(RingField(ring, submitTail), 4, &submitTail);
+      ReadUserMem(RingField(ring, completionHead), 4, &completionHead);
+      ReadUserMem(RingField(ring, completionTail), 4, &completionTail);
+      if ((submitHead == submitTail)
+		|| (completionTail - completionHead >= SyscallRingSize))
+	 break;
+
+      request = RingField(ring, requests) + sizeof(SyscallRingRequest)
+			* (submitHead & (SyscallRingSize - 1));
+      ReadUserMem(request + offsetof(SyscallRingRequest, code), 4, &code);
+      ReadUserMem(request + offsetof(SyscallRingRequest, arg1), 4, &arg1);
+      ReadUserMem(request + offsetof(SyscallRingRequest, arg2), 4, &arg2);
+      ReadUserMem(request + offsetof(SyscallRingRequest, arg3), 4, &arg3);
+      ReadUserMem(request + offsetof(SyscallRingRequest, tag), 4, &tag);
+      WriteUserMem(RingField(ring, submitHead), 4, submitHead + 1);
+
+      DEBUG('a', "Ring request %d: system call %d (%d, %d, %d)\n",
+	    tag, code, arg1, arg2, arg3);
+      switch (code) {
+	 case SysCall_Read:
+	    result = ReadUser(arg1, arg2, arg3);
+	    break;
+	 case SysCall_Write:
+	    result = WriteUser(arg1, arg2, arg3);
+	    break;
+	 case SysCall_Yield:
+	    currentThread->YieldCPU();
+	    result = 0;
+	    break;
+	 case SysCall_Sleep:
+	    if (arg1 > 0)
+	       result = sleepQueue->Sleep(arg1);
+	    else {
+	       currentThread->YieldCPU();
+	       result = 0;
+	    }
+	    break;
+	 default:
+	    result = -1;
+	    break;
+      }
+
+      ReadUserMem(RingField(ring, completionTail), 4, &completionTail);
+      completion = RingField(ring, completions)
+			+ sizeof(SyscallRingCompletion)
+			* (completionTail & (SyscallRingSize - 1));
+      WriteUserMem(completion + offsetof(SyscallRingCompletion, tag), 4, tag);
+      WriteUserMem(completion + offsetof(SyscallRingCompletion, result), 4,
+		   result);
+      WriteUserMem(RingField(ring, completionTail), 4, completionTail + 1);
+      done++;
+   }
+   return done;
+}
+
+//----------------------------------------------------------------------
+// ExitProcess
+// 	End the calling process with exit status "status": free its
+//	address space, and halt if it was the last one.  Used by Exit,
+//	and to kill a process that can't go on.
+//----------------------------------------------------------------------
+
+static void
+ExitProcess (int status)
+{
+   DEBUG('a', "Thread \"%s\" exiting with status %d\n",
+	    currentThread->getName(), status);
+   currentThread->space->PrintMemStats(currentThread->getPID());
+   delete currentThread->space;	// give its frames back
+   currentThread->space = NULL;
+   if (ProcessAddressSpace::NumSpaces() == 0) {
+      DEBUG('a', "Last user process exited.\n");
+      synchConsole->Flush();
+      interrupt->Halt();
+   }
+   currentThread->setExitStatus(status);
+   currentThread->FinishThread();	// the parent can now Join us
+}
+
+//----------------------------------------------------------------------
+// System call handlers
+// 	One routine per system call, called from ExceptionHandler with
+//	the arguments still in r4..r7.  A handler that returns a value
+//	puts it in r2.  The program counters have already been advanced
+//	past the syscall instruction by the time a handler runs.
+//----------------------------------------------------------------------
+
+static void
+SyscallHalt ()
+{
+   DEBUG('a', "Shutdown, initiated by user program.\n");
+   synchConsole->Flush();
+   interrupt->Halt();
+}
+
+static void
+SyscallExit ()
+{
+   ExitProcess(machine->ReadRegister(4));
+}
+
+static void
+SyscallJoin ()
+{
+   machine->WriteRegister(2, processTable->Join(currentThread->getPID(),
+						machine->ReadRegister(4)));
+}
+
+static void
+SyscallGetPID ()
+{
+   machine->WriteRegister(2, currentThread->getPID());
+}
+
+static void
+SyscallGetPPID ()
+{
+   machine->WriteRegister(2, currentThread->getPPID());
+}
+
+static void
+SyscallExec ()
+{
+   char filename[MaxFileNameLength];
+   OpenFile *executable;
+   ProcessAddressSpace *space;
+
+   ReadUserString(machine->ReadRegister(4), filename, MaxFileNameLength);
+   executable = fileSystem->Open(filename);
+   if ((executable == NULL)
+	|| (ProcessAddressSpace::CountImagePages(executable) == -1)) {
+      DEBUG('a', "Exec: unable to run %s\n", filename);
+      delete executable;		// the caller carries on
+      machine->WriteRegister(2, -1);
+      return;
+   }
+   delete currentThread->space;	// free the old frames first, so the
+   space = new ProcessAddressSpace(executable, filename);	// new image
+						// can use them
+   currentThread->space = space;	// space now owns executable
+#ifdef VM
+   if (loadControl != NULL)
+      loadControl->Admit(space);	// wait until it fits in memory
+#endif
+
+   space->InitUserModeCPURegisters();
+   scheduler->ActivateAddressSpace(space);
+   machine->Run();		// jump to the new program
+   ASSERT(FALSE);		// machine->Run never returns
+}
+
+static void
+SyscallFork ()
+{
+   NachOSThread *child = new NachOSThread("forked thread");
+
+   child->space = new ProcessAddressSpace(currentThread->space);
+   processTable->MakeJoinable(child->getPID());
+   machine->WriteRegister(2, 0);	// the child sees Fork return 0
+   child->SaveUserState();
+   machine->WriteRegister(2, child->getPID());
+   child->ThreadFork(ForkStartFunction, 0);
+}
+
+static void
+SyscallPrintInt ()
+{
+   char buf[16];
+
+   sprintf(buf, "%d", machine->ReadRegister(4));
+   synchConsole->Write(buf, strlen(buf));
+}
+
+static void
+SyscallPrintChar ()
+{
+   synchConsole->PutChar(machine->ReadRegister(4));   // echo it!
+}
+
+static void
+SyscallPrintString ()
+{
+   WriteUserConsole(machine->ReadRegister(4), -1);
+}
+
+static void
+SyscallPrintIntHex ()
+{
+   char buf[16];
+
+   sprintf(buf, "0x%x", (unsigned)machine->ReadRegister(4));
+   synchConsole->Write(buf, strlen(buf));
+}
+
+static void
+SyscallCreate ()
+{
+   char filename[MaxFileNameLength];
+
+   ReadUserString(machine->ReadRegister(4), filename, MaxFileNameLength);
+   machine->WriteRegister(2, fileSystem->Create(filename, 0) ? 0 : -1);
+}
+
+static void
+SyscallOpen ()
+{
+   char filename[MaxFileNameLength];
+   OpenFile *file;
+   int id = -1;
+
+   ReadUserString(machine->ReadRegister(4), filename, MaxFileNameLength);
+   file = fileSystem->Open(filename);
+   if (file != NULL) {
+      id = currentThread->space->AddOpenFile(file, filename);
+      if (id == -1)			// file table full
+	 delete file;
+   }
+   machine->WriteRegister(2, id);
+}
+
+static void
+SyscallClose ()
+{
+   int id = machine->ReadRegister(4);
+
+   machine->WriteRegister(2, currentThread->space->CloseFile(id) ? 0 : -1);
+}
+
+static void
+SyscallYield ()
+{
+   currentThread->YieldCPU();
+}
+
+static void
+SyscallSleep ()
+{
+   int ticks = machine->ReadRegister(4);
+
+   if (ticks <= 0) {
+      currentThread->YieldCPU();
+      machine->WriteRegister(2, 0);
+   } else
+      machine->WriteRegister(2, sleepQueue->Sleep(ticks));
+}
+
+static void
+SyscallTime ()
+{
+   machine->WriteRegister(2, stats->totalTicks);
+}
+
+static void
+SyscallRead ()
+{
+   machine->WriteRegister(2, ReadUser(machine->ReadRegister(4),
+				      machine->ReadRegister(5),
+				      machine->ReadRegister(6)));
+}
+
+static void
+SyscallWrite ()
+{
+   machine->WriteRegister(2, WriteUser(machine->ReadRegister(4),
+				       machine->ReadRegister(5),
+				       machine->ReadRegister(6)));
+}
+
+static void
+SyscallMmap ()
+{
+   int id = machine->ReadRegister(4);
+   int length = machine->ReadRegister(5);
+
+   machine->WriteRegister(2, currentThread->space->MapFile(id, length));
+}
+
+static void
+SyscallMunmap ()
+{
+   int vaddr = machine->ReadRegister(4);
+
+   machine->WriteRegister(2,
+		currentThread->space->UnmapFile(vaddr) ? 0 : -1);
+}
+
+static void
+SyscallRingSetup ()
+{
+   int ring = machine->ReadRegister(4);
+
+   if (ring == 0) {
+      currentThread->space->SetSyscallRing(-1);
+      machine->WriteRegister(2, 0);
+      return;
+   }
+   if ((ring % 4 != 0)
+	 || !currentThread->space->IsWritable(ring, sizeof(SyscallRing))) {
+      machine->WriteRegister(2, -1);
+      return;
+   }
+   WriteUserMem(RingField(ring, submitHead), 4, 0);
+   WriteUserMem(RingField(ring, submitTail), 4, 0);
+   WriteUserMem(RingField(ring, completionHead), 4, 0);
+   WriteUserMem(RingField(ring, completionTail), 4, 0);
+   currentThread->space->SetSyscallRing(ring);
+   machine->WriteRegister(2, 0);
+}
+
+static void
+SyscallRingEnter ()
+{
+   machine->WriteRegister(2, DrainSyscallRing());
+}
+
+static void
+SyscallSchedStats ()
+{
+   machine->WriteRegister(2, CopySchedStats(machine->ReadRegister(4),
+					    machine->ReadRegister(5)));
+}
+
+static void
+SyscallGetMemStats ()
+{
+   int values[MemStatSize];
+   int vaddr = machine->ReadRegister(4);
+   int size = machine->ReadRegister(5);
+   int i;
+
+   currentThread->space->GetMemStats(values);
+   if (size > MemStatSize) size = MemStatSize;
+   for (i = 0; i < size; i++)
+      WriteUserMem(vaddr + 4*i, 4, values[i]);
+   machine->WriteRegister(2, (size > 0) ? size : 0);
+}
+
+static void
+SyscallCheckpoint ()
+{
+   char filename[MaxFileNameLength];
+   int registers[NumTotalRegs];
+   int i;
+
+   ReadUserString(machine->ReadRegister(4), filename, MaxFileNameLength);
+   for (i = 0; i < NumTotalRegs; i++)
+      registers[i] = machine->ReadRegister(i);
+   registers[2] = 1;		// what Checkpoint returns on a Restore
+   machine->WriteRegister(2,
+	(currentThread->space->Checkpoint(filename, registers) >= 0) ? 0 : -1);
+}
+
+static void
+SyscallRestore ()
+{
+   char filename[MaxFileNameLength];
+   int registers[NumTotalRegs];
+   OpenFile *checkpoint;
+   ProcessAddressSpace *space = NULL;
+
+   ReadUserString(machine->ReadRegister(4), filename, MaxFileNameLength);
+   checkpoint = fileSystem->Open(filename);
+   if (checkpoint != NULL)
+      space = ProcessAddressSpace::Restore(checkpoint, filename, registers);
+   if (space == NULL) {
+      DEBUG('a', "Restore: unable to restore from %s\n", filename);
+      delete checkpoint;
+      machine->WriteRegister(2, -1);
+      return;
+   }
+   delete currentThread->space;	// free the old frames first, so the
+   currentThread->space = space;	// saved pages can use them
+   if (!space->RestorePages(checkpoint)) {
+      printf("Not enough memory to restore from %s in thread \"%s\"\n",
+	     filename, currentThread->getName());
+      delete checkpoint;
+      ExitProcess(-1);
+   }
+   delete checkpoint;
+#ifdef VM
+   if (loadControl != NULL)
+      loadControl->Admit(space);	// wait until it fits in memory
+#endif
+
+   space->RestoreUserModeCPURegisters(registers);
+   scheduler->ActivateAddressSpace(space);
+   machine->Run();		// carry on from the checkpoint
+   ASSERT(FALSE);		// machine->Run never returns
+}
+
+//----------------------------------------------------------------------
+// syscallTable
+// 	The handler for each system call code, or NULL if the system call
+//	isn't implemented.  Filled in by InitializeSyscalls.
+//----------------------------------------------------------------------
+
+typedef void (*SyscallHandler)();
+
+static SyscallHandler syscallTable[NumSysCalls];
+
+//----------------------------------------------------------------------
+// InitializeSyscalls
+// 	Set up the system call table.  Called once, at boot.
+//----------------------------------------------------------------------
+
+void
+InitializeSyscalls()
+{
+    int i;
+
+    for (i = 0; i < NumSysCalls; i++)
+	syscallTable[i] = NULL;
+    syscallTable[SysCall_Halt] = SyscallHalt;
+    syscallTable[SysCall_Exit] = SyscallExit;
+    syscallTable[SysCall_Exec] = SyscallExec;
+    syscallTable[SysCall_Join] = SyscallJoin;
+    syscallTable[SysCall_Create] = SyscallCreate;
+    syscallTable[SysCall_Open] = SyscallOpen;
+    syscallTable[SysCall_Read] = SyscallRead;
+    syscallTable[SysCall_Write] = SyscallWrite;
+    syscallTable[SysCall_Close] = SyscallClose;
+    syscallTable[SysCall_Fork] = SyscallFork;
+    syscallTable[SysCall_Yield] = SyscallYield;
+    syscallTable[SysCall_Sleep] = SyscallSleep;
+    syscallTable[SysCall_GetPID] = SyscallGetPID;
+    syscallTable[SysCall_GetPPID] = SyscallGetPPID;
+    syscallTable[SysCall_Time] = SyscallTime;
+    syscallTable[SysCall_PrintInt] = SyscallPrintInt;
+    syscallTable[SysCall_PrintChar] = SyscallPrintChar;
+    syscallTable[SysCall_PrintString] = SyscallPrintString;
+    syscallTable[SysCall_PrintIntHex] = SyscallPrintIntHex;
+    syscallTable[SysCall_SchedStats] = SyscallSchedStats;
+    syscallTable[SysCall_GetMemStats] = SyscallGetMemStats;
+    syscallTable[SysCall_Mmap] = SyscallMmap;
+    syscallTable[SysCall_Munmap] = SyscallMunmap;
+    syscallTable[SysCall_RingSetup] = SyscallRingSetup;
+    syscallTable[SysCall_RingEnter] = SyscallRingEnter;
+    syscallTable[SysCall_Checkpoint] = SyscallCheckpoint;
+    syscallTable[SysCall_Restore] = SyscallRestore;
+}
+
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Step the program counters past the syscall instruction, so that
+//	the user program carries on after the system call.  (Or else
+//	it would loop making the same system call forever!)  This is done
+//	before the handler runs, so that a forked child, whose registers
+//	are copied inside the handler, carries on in the right place too.
+//----------------------------------------------------------------------
+
+static void
+AdvancePC()
+{
+    machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+    machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
+    machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
 
 //----------------------------------------------------------------------
 // ExceptionHandler
@@ -43,120 +731,48 @@
 //
 //	The result of the system call, if any, must be put back into r2. 
 //
-// And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
+//	The system call code indexes syscallTable, so finding the handler
+//	costs the same for every system call.  Any requests waiting in the
+//	process's system call ring are carried out first, so they are
+//	never overtaken by a later system call.
 //
 //	"which" is the kind of exception.  The list of possible exceptions 
 //	are in machine.h.
 //----------------------------------------------------------------------
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
-
-static void ConvertIntToHex (unsigned v, Console *console)
-{
-   unsigned x;
-   if (v == 0) return;
-   ConvertIntToHex (v/16, console);
-   x = v % 16;
-   if (x < 10) {
-      writeDone->P() ;
-      console->PutChar('0'+x);
-   }
-   else {
-      writeDone->P() ;
-      console->PutChar('a'+x-10);
-   }
-}
-
 void
 ExceptionHandler(ExceptionType which)
 {
     int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
-    unsigned printvalus;        // Used for printing in hex
-    if (!initializedConsoleSemaphores) {
-       readAvail = new Semaphore("read avail", 0);
-       writeDone = new Semaphore("write done", 1);
-       initializedConsoleSemaphores = true;
-    }
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);;
+    int vaddr;
+    FaultResult result;
 
-    if ((which == SyscallException) && (type == SysCall_Halt)) {
-	DEBUG('a', "Shutdown, initiated by user program.\n");
-   	interrupt->Halt();
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintInt)) {
-       printval = machine->ReadRegister(4);
-       if (printval == 0) {
-	  writeDone->P() ;
-          console->PutChar('0');
+    if ((which == PageFaultException) || (which == ReadOnlyException)) {
+       vaddr = machine->ReadRegister(BadVAddrReg);
+       if (which == PageFaultException)
+	  result = currentThread->space->HandlePageFault(vaddr);
+       else
+	  result = currentThread->space->HandleReadOnlyFault(vaddr);
+       if (result == FaultBadAddress) {
+	  printf("%s 0x%x in thread \"%s\"\n",
+		 (which == PageFaultException) ? "Bad address"
+					       : "Write to read-only address",
+		 vaddr, currentThread->getName());
+	  ASSERT(FALSE);
        }
-       else {
-          if (printval < 0) {
-	     writeDone->P() ;
-             console->PutChar('-');
-             printval = -printval;
-          }
-          tempval = printval;
-          exp=1;
-          while (tempval != 0) {
-             tempval = tempval/10;
-             exp = exp*10;
-          }
-          exp = exp/10;
-          while (exp > 0) {
-	     writeDone->P() ;
-             console->PutChar('0'+(printval/exp));
-             printval = printval % exp;
-             exp = exp/10;
-          }
+       if (result == FaultNoMemory) {
+	  printf("Out of memory at 0x%x in thread \"%s\", killing it\n",
+		 vaddr, currentThread->getName());
+	  ExitProcess(-1);
        }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+       return;			// retry the faulting instruction
     }
-    else if ((which == SyscallException) && (type == SysCall_PrintChar)) {
-	writeDone->P() ;
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintString)) {
-       vaddr = machine->ReadRegister(4);
-       machine->ReadMem(vaddr, 1, &memval);
-       while ((*(char*)&memval) != '\0') {
-	  writeDone->P() ;
-          console->PutChar(*(char*)&memval);
-          vaddr++;
-          machine->ReadMem(vaddr, 1, &memval);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintIntHex)) {
-       printvalus = (unsigned)machine->ReadRegister(4);
-       writeDone->P() ;
-       console->PutChar('0');
-       writeDone->P() ;
-       console->PutChar('x');
-       if (printvalus == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          ConvertIntToHex (printvalus, console);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+
+    if ((which == SyscallException) && (type >= 0) && (type < NumSysCalls)
+					&& (syscallTable[type] != NULL)) {
+       AdvancePC();
+       if ((type != SysCall_RingEnter) && (type != SysCall_RingSetup))
+	  DrainSyscallRing();
+       (*syscallTable[type])();
     } else {
 	printf("Unexpected user mode exception %d %d\n", which, type);
 	ASSERT(FALSE);
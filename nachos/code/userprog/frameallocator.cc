@@ -0,0 +1,169 @@
+// frameallocator.cc 
+//	Routines to allocate and free physical page frames for
+//	user address spaces.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "frameallocator.h"
+
+//----------------------------------------------------------------------
+// FrameAllocator::FrameAllocator
+// 	Initialize the allocator, with every frame free.  The machine
+//	starts out with mainMemory cleared, so every frame is also
+//	already zeroed.
+//
+//	"frameCount" is the number of physical page frames in mainMemory.
+//----------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(int frameCount)
+{
+    int i;
+
+    numFrames = frameCount;
+    frameMap = new BitMap(numFrames);
+    zeroMap = new BitMap(numFrames);
+    for (i = 0; i < numFrames; i++)
+	zeroMap->Mark(i);
+    refCount = new int[numFrames];
+    bzero(refCount, numFrames * sizeof(int));
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::~FrameAllocator
+// 	De-allocate the allocator.
+//----------------------------------------------------------------------
+
+FrameAllocator::~FrameAllocator()
+{
+    delete frameMap;
+    delete zeroMap;
+    delete [] refCount;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::AllocateFrame
+// 	Find a free frame and mark it in use, with a single mapping.
+//	The frame is zeroed, so that a program can't see what the
+//	previous owner left behind; only this frame is touched, never
+//	the rest of mainMemory.
+//
+//	A frame zeroed ahead of time is taken if there is one; only if
+//	there isn't does the caller pay for zeroing one now.
+//
+//	Returns the frame number, or -1 if every frame is in use.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::AllocateFrame()
+{
+    int frame;
+
+    for (frame = 0; frame < numFrames; frame++)
+	if (zeroMap->Test(frame))
+	    break;
+    if (frame < numFrames) {
+	zeroMap->Clear(frame);
+	frameMap->Mark(frame);
+    } else {
+	frame = frameMap->Find();
+	if (frame == -1)
+	    return -1;
+	bzero(&(machine->mainMemory[frame * PageSize]), PageSize);
+    }
+    refCount[frame] = 1;
+    DEBUG('a', "Allocated frame %d, %d frames left\n", frame, NumFree());
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::AllocateFrames
+// 	Find "count" free frames in a row, starting at a multiple of
+//	"count", for a large page.  Each is set up as by AllocateFrame.
+//
+//	Returns the first frame, or -1 if there is no such run.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::AllocateFrames(int count)
+{
+    int first, i;
+
+    for (first = 0; first + count <= numFrames; first += count) {
+	for (i = 0; i < count; i++)
+	    if (frameMap->Test(first + i))
+		break;
+	if (i < count)
+	    continue;
+	for (i = 0; i < count; i++) {
+	    frameMap->Mark(first + i);
+	    refCount[first + i] = 1;
+	    if (zeroMap->Test(first + i))
+		zeroMap->Clear(first + i);
+	    else
+		bzero(&(machine->mainMemory[(first + i) * PageSize]),
+		      PageSize);
+	}
+	DEBUG('a', "Allocated frames %d-%d, %d frames left\n", first,
+	      first + count - 1, NumFree());
+	return first;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::ShareFrame
+// 	Note that one more address space maps "frame".
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::ShareFrame(int frame)
+{
+    ASSERT(frameMap->Test(frame));
+    refCount[frame]++;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::FreeFrame
+// 	Drop one mapping of "frame".  Once nobody maps it, return it
+//	to the pool of free frames.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::FreeFrame(int frame)
+{
+    ASSERT(frameMap->Test(frame) && refCount[frame] > 0);
+    if (--refCount[frame] > 0)
+	return;
+    frameMap->Clear(frame);
+    DEBUG('a', "Freed frame %d, %d frames left\n", frame, NumFree());
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::ZeroFreeFrames
+// 	Zero up to "count" free frames that still hold whatever their
+//	last owner left in them, so that later allocations can skip
+//	zeroing.  Called when the machine has nothing better to do.
+//
+//	Returns the number of frames zeroed.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::ZeroFreeFrames(int count)
+{
+    int frame, zeroed = 0;
+
+    for (frame = 0; (frame < numFrames) && (zeroed < count); frame++) {
+	if (frameMap->Test(frame) || zeroMap->Test(frame))
+	    continue;
+	bzero(&(machine->mainMemory[frame * PageSize]), PageSize);
+	zeroMap->Mark(frame);
+	zeroed++;
+    }
+    if (zeroed > 0)
+	DEBUG('a', "Zeroed %d free frames while idle\n", zeroed);
+    return zeroed;
+}
@@ -0,0 +1,62 @@
+// frameallocator.h 
+//	Data structures to keep track of which physical page frames of
+//	the simulated machine's main memory are in use.
+//
+//	Every address space gets its own frames from the one global
+//	allocator, so several user programs can be resident at once
+//	without clobbering each other.
+//
+//	A frame may be mapped by several address spaces at once (for
+//	instance, after a copy-on-write Fork), so each frame carries a
+//	count of its mappings, and only goes back to the free pool when
+//	the last one is dropped.
+//
+//	Every frame handed out is zeroed.  Freed frames are zeroed ahead
+//	of time while the machine is idle (see ZeroFreeFrames), so that
+//	most allocations find a frame that is already clean.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMEALLOCATOR_H
+#define FRAMEALLOCATOR_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+// The following class defines the physical frame allocator.  It is
+// a thin layer over a BitMap with one bit per frame of mainMemory,
+// plus a reference count per frame.
+
+class FrameAllocator {
+  public:
+    FrameAllocator(int frameCount);	// Initialize, with all frames free
+    ~FrameAllocator();			// De-allocate the allocator
+
+    int AllocateFrame();		// Find a free frame, mark it in use,
+					// zero it and return its number.
+					// Return -1 if memory is full.
+    int AllocateFrames(int count);	// Same for "count" contiguous
+					// frames, aligned to "count";
+					// returns the first
+    void ShareFrame(int frame);		// One more mapping of "frame"
+    void FreeFrame(int frame);		// Drop a mapping of "frame"; return
+					// it to the free pool if that was
+					// the last one
+    int RefCount(int frame) { return refCount[frame]; }
+					// Number of mappings of "frame"
+    int NumFree() { return frameMap->NumClear(); }
+					// Number of frames still available
+    int ZeroFreeFrames(int count);	// Zero up to "count" free frames
+					// ahead of time; returns how many
+
+  private:
+    int numFrames;
+    BitMap *frameMap;			// one bit per frame, set if in use
+    BitMap *zeroMap;			// one bit per frame, set if it is
+					// free and already zeroed
+    int *refCount;			// mappings of each frame
+};
+
+#endif // FRAMEALLOCATOR_H
@@ -18,6 +18,11 @@
 // LaunchUserProcess
 // 	Run a user program.  Open the executable, load it into
 //	memory, and jump to it.
+//
+//	This also brings up the console used by the console system
+//	calls.  It isn't started at boot, where it would fight ConsoleTest
+//	for the keyboard, and its polling would keep Nachos from ever
+//	going idle when no user program is run.
 //----------------------------------------------------------------------
 
 void
@@ -30,13 +35,23 @@ LaunchUserProcess(char *filename)
 	printf("Unable to open file %s\n", filename);
 	return;
     }
-    space = new ProcessAddressSpace(executable);    
-    currentThread->space = space;
-
-    delete executable;			// close file
+    if (ProcessAddressSpace::CountImagePages(executable) == -1) {
+	printf("Unable to run %s\n", filename);
+	delete executable;
+	return;
+    }
+    if (synchConsole == NULL)
+	synchConsole = new SynchConsole(NULL, NULL);
+    space = new ProcessAddressSpace(executable, filename);    
+    currentThread->space = space;	// the space keeps executable open
+					// to load pages on demand
+#ifdef VM
+    if (loadControl != NULL)
+	loadControl->Admit(space);	// wait until it fits in memory
+#endif
 
     space->InitUserModeCPURegisters();		// set the initial register values
-    space->RestoreContextOnSwitch();		// load page table register
+    scheduler->ActivateAddressSpace(space);	// load page table register
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
@@ -44,6 +59,53 @@ LaunchUserProcess(char *filename)
 					// by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// RestoreUserProcess
+// 	Carry on running the user process saved in the checkpoint file
+//	"filename" by the Checkpoint system call, perhaps before Nachos
+//	was last restarted.  Like LaunchUserProcess, but the address
+//	space and registers come from the checkpoint.
+//----------------------------------------------------------------------
+
+void
+RestoreUserProcess(char *filename)
+{
+    OpenFile *checkpoint = fileSystem->Open(filename);
+    ProcessAddressSpace *space;
+    int registers[NumTotalRegs];
+
+    if (checkpoint == NULL) {
+	printf("Unable to open file %s\n", filename);
+	return;
+    }
+    space = ProcessAddressSpace::Restore(checkpoint, filename, registers);
+    if (space == NULL) {
+	printf("Unable to restore from %s\n", filename);
+	delete checkpoint;
+	return;
+    }
+    if (synchConsole == NULL)
+	synchConsole = new SynchConsole(NULL, NULL);
+    if (!space->RestorePages(checkpoint)) {
+	printf("Not enough memory to restore from %s\n", filename);
+	delete space;
+	delete checkpoint;
+	return;
+    }
+    delete checkpoint;
+    currentThread->space = space;
+#ifdef VM
+    if (loadControl != NULL)
+	loadControl->Admit(space);	// wait until it fits in memory
+#endif
+
+    space->RestoreUserModeCPURegisters(registers);
+    scheduler->ActivateAddressSpace(space);
+
+    machine->Run();			// carry on from the checkpoint
+    ASSERT(FALSE);			// machine->Run never returns
+}
+
 // Data structures needed for the console test.  Threads making
 // I/O requests wait on a Semaphore to delay until the I/O completes.
 
@@ -0,0 +1,281 @@
+// synchconsole.cc 
+//	Routines to synchronously access the console.  The physical
+//	console is an asynchronous device; this is a layer on top of it
+//	that makes output wait until the device is free, and input wait
+//	until a character has arrived.
+//
+//	Output goes through a ring buffer that the write-done interrupt
+//	drains, so writing a string costs one copy into the ring, rather
+//	than a wait for the device per character.  The ring is shared
+//	with the interrupt handler, so it is only touched with interrupts
+//	disabled.  Likewise, input is assembled into lines by the
+//	read-avail interrupt, and a reader gets a whole line at a time.
+//	Semaphores synchronize the interrupt handlers with the requesting
+//	threads.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synchconsole.h"
+
+//----------------------------------------------------------------------
+// ConsoleWriteDone, ConsoleReadAvail
+// 	Console interrupt handlers.  Need these to be C routines, because 
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+ConsoleWriteDone (int arg)
+{
+    SynchConsole* console = (SynchConsole *)arg;
+
+    console->WriteDone();
+}
+
+static void
+ConsoleReadAvail (int arg)
+{
+    SynchConsole* console = (SynchConsole *)arg;
+
+    console->ReadAvail();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the synchronous interface to the console, in turn
+//	initializing the raw console.
+//
+//	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
+//	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
+//----------------------------------------------------------------------
+
+SynchConsole::SynchConsole(char *readFile, char *writeFile)
+{
+    writeLock = new Lock("synch console write lock");
+    outputDone = new Semaphore("synch console output", 0);
+    outputWaiting = FALSE;
+    readLock = new Lock("synch console read lock");
+    lineAvail = new Semaphore("synch console line", 0);
+    lineWaiting = FALSE;
+    outHead = outCount = 0;
+    outBusy = FALSE;
+    editLength = 0;
+    inHead = inCount = inLines = 0;
+    console = new Console(readFile, writeFile, ConsoleReadAvail,
+			  ConsoleWriteDone, (int) this);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate data structures needed for the synchronous console
+//	abstraction.
+//----------------------------------------------------------------------
+
+SynchConsole::~SynchConsole()
+{
+    delete console;
+    delete lineAvail;
+    delete readLock;
+    delete outputDone;
+    delete writeLock;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Write
+// 	Queue "size" characters from "buffer" for output.  Returns as soon
+//	as they are all in the ring; the caller only waits for the device
+//	if the ring fills up.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Write(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int i;
+
+    writeLock->Acquire();
+    oldLevel = interrupt->SetLevel(IntOff);
+    for (i = 0; i < size; i++) {
+	while (outCount == ConsoleBufferSize) {
+	    StartOutput();
+	    WaitForOutput();		// ring full, wait for some room
+	}
+	outRing[(outHead + outCount) % ConsoleBufferSize] = buffer[i];
+	outCount++;
+    }
+    StartOutput();
+    (void) interrupt->SetLevel(oldLevel);
+    writeLock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Flush
+// 	Wait until everything queued so far has been printed.  Called
+//	before halting, so that no output is lost.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Flush()
+{
+    IntStatus oldLevel;
+
+    writeLock->Acquire();
+    oldLevel = interrupt->SetLevel(IntOff);
+    while (outBusy || (outCount > 0)) {
+	StartOutput();
+	WaitForOutput();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    writeLock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::StartOutput
+// 	If the device is idle, send it the oldest queued character.
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::StartOutput()
+{
+    char ch;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    if (outBusy || (outCount == 0))
+	return;
+    ch = outRing[outHead];
+    outHead = (outHead + 1) % ConsoleBufferSize;
+    outCount--;
+    outBusy = TRUE;
+    console->PutChar(ch);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WaitForOutput
+// 	Wait for the device to finish the character it is printing.
+//	Interrupts must be disabled; only the holder of writeLock waits.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::WaitForOutput()
+{
+    ASSERT(interrupt->getLevel() == IntOff);
+    outputWaiting = TRUE;
+    outputDone->P();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Read
+// 	Read the next line of input into "buffer", waiting for one to be
+//	typed in if necessary.  Stops after the newline, or after "size"
+//	characters (leaving the rest of the line for the next Read).
+//
+//	Returns the number of characters read, or 0 at end of file.
+//----------------------------------------------------------------------
+
+int
+SynchConsole::Read(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int ch, n = 0;
+
+    readLock->Acquire();
+    oldLevel = interrupt->SetLevel(IntOff);
+    while (inLines == 0) {
+	lineWaiting = TRUE;
+	lineAvail->P();
+    }
+    while (n < size) {
+	ch = inRing[inHead];
+	inHead = (inHead + 1) % ConsoleBufferSize;
+	inCount--;
+	if (ch == ConsoleEOF) {		// consumed, but not returned
+	    inLines--;
+	    break;
+	}
+	buffer[n++] = (char) ch;
+	if (ch == '\n') {
+	    inLines--;
+	    break;
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    readLock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::EndLine
+// 	The line being typed in is complete.  Move it to the input ring,
+//	followed by "terminator" ('\n' or ConsoleEOF), and wake up the
+//	reader.  If the ring has no room for it, the line is lost.
+//	Called from the interrupt handler.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::EndLine(int terminator)
+{
+    int i;
+
+    if (inCount + editLength + 1 <= ConsoleBufferSize) {
+	for (i = 0; i < editLength; i++)
+	    inRing[(inHead + inCount++) % ConsoleBufferSize] = editLine[i];
+	inRing[(inHead + inCount++) % ConsoleBufferSize] = terminator;
+	inLines++;
+	if (lineWaiting) {
+	    lineWaiting = FALSE;
+	    lineAvail->V();
+	}
+    }
+    editLength = 0;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WriteDone, SynchConsole::ReadAvail
+// 	Called by the console device interrupt handlers, to signal that
+//	an output character is done, or an input character has arrived.
+//	When a character is done, start on the next one in the ring, and
+//	let a waiting writer know there is room.  When one arrives, apply
+//	the line discipline to it.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::WriteDone()
+{
+    outBusy = FALSE;
+    StartOutput();			// keep the device going
+    if (outputWaiting) {
+	outputWaiting = FALSE;
+	outputDone->V();
+    }
+}
+
+void
+SynchConsole::ReadAvail()
+{
+    char ch = console->GetChar();
+
+    switch (ch) {
+      case '\b':			// backspace or delete: erase a character
+      case '\177':
+	if (editLength > 0)
+	    editLength--;
+	break;
+      case '\025':			// control-U: erase the line
+	editLength = 0;
+	break;
+      case '\004':			// control-D: end of file
+	EndLine(ConsoleEOF);
+	break;
+      case '\n':
+	EndLine('\n');
+	break;
+      default:
+	if (editLength < ConsoleBufferSize - 1)	// leave room for the '\n'
+	    editLine[editLength++] = ch;
+	break;
+    }
+}
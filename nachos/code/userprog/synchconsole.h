@@ -0,0 +1,93 @@
+// synchconsole.h 
+// 	Data structures to export a synchronous interface to the raw 
+//	console device, for the system calls that do terminal I/O.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
+
+#include "console.h"
+#include "synch.h"
+
+// The following class defines a "synchronous" console abstraction.
+// Like the disk, the raw console is asynchronous -- PutChar returns
+// immediately, and an interrupt signals that the character is out; an
+// interrupt also signals that an input character has arrived.
+//
+// Output is buffered: writers copy characters into a ring buffer and
+// carry on, and the write-done interrupt feeds the device from the
+// ring, one character after another.  A writer only waits when the
+// ring is full.
+//
+// Input goes through a simple line discipline: characters are collected
+// into a line as they arrive, with backspace (or delete) erasing the
+// last character, control-U erasing the whole line, and control-D
+// ending the line without a newline -- on an empty line, that reads as
+// end of file.  A reader is only woken once a whole line is ready.
+// There is no echo; the terminal we run on does that.
+//
+// There is a single SynchConsole, shared by every user program, so
+// that system calls don't have to set up a device of their own.
+
+#define ConsoleBufferSize	256	// characters of buffered output,
+					// and of buffered input
+
+#define ConsoleEOF		-1	// end-of-file marker in the input ring
+
+class SynchConsole {
+  public:
+    SynchConsole(char *readFile, char *writeFile);
+					// Initialize a synchronous console,
+					// by initializing the raw Console.
+    ~SynchConsole();			// De-allocate the synch console data
+
+    void PutChar(char ch) { Write(&ch, 1); }
+					// Queue "ch" for output
+    void Write(char *buffer, int size);	// Queue "size" characters for output,
+					// waiting only if the ring fills up
+    void Flush();			// Wait until all queued output is out
+    int Read(char *buffer, int size);	// Wait for a line of input, and
+					// return up to "size" characters of
+					// it; 0 at end of file
+
+    void WriteDone();			// Called by the console device
+    void ReadAvail();			// interrupt handlers
+
+  private:
+    Console *console;			// Raw console device
+    Lock *writeLock;			// One writer at a time, so output
+					// from different writes isn't mixed
+    Semaphore *outputDone;		// For the writer to wait on until
+					// the next character is out
+    bool outputWaiting;			// Is anybody waiting on outputDone?
+    Lock *readLock;			// One reader at a time
+    Semaphore *lineAvail;		// For the reader to wait on until
+					// a line is ready
+    bool lineWaiting;			// Is anybody waiting on lineAvail?
+
+    char outRing[ConsoleBufferSize];	// Characters not yet sent out
+    int outHead;			// Index of the oldest one
+    int outCount;			// How many there are
+    bool outBusy;			// Is the device printing a character?
+
+    char editLine[ConsoleBufferSize];	// The line being typed in
+    int editLength;			// How much of it there is
+    int inRing[ConsoleBufferSize];	// Completed lines, each ending in
+					// '\n' or ConsoleEOF
+    int inHead;				// Index of the oldest character
+    int inCount;			// How many characters there are
+    int inLines;			// How many complete lines there are
+
+    void StartOutput();			// Hand the device the next character,
+					// if it is idle
+    void WaitForOutput();		// Wait for the next write-done
+    void EndLine(int terminator);	// Move the edited line to the input
+					// ring, ending it with "terminator"
+};
+
+#endif // SYNCHCONSOLE_H
@@ -47,8 +47,61 @@
 
 #define SysCall_PrintIntHex  	20
 
+#define SysCall_SchedStats	21
+
+/* Layout of the buffer filled in by SchedStats.  The two histograms
+ * have SchedStatBuckets power-of-two buckets each: bucket 0 counts
+ * 0 ticks, bucket i counts [2^(i-1), 2^i) ticks, and the last bucket
+ * counts everything larger.
+ */
+#define SchedStatBuckets		16
+#define SchedStat_Dispatches		0	/* all context switches */
+#define SchedStat_Voluntary		1
+#define SchedStat_Involuntary		2
+#define SchedStat_TotalTicks		3
+#define SchedStat_MyWaitTicks		4	/* calling thread only */
+#define SchedStat_MyRunTicks		5
+#define SchedStat_MyVoluntary		6
+#define SchedStat_MyInvoluntary		7
+#define SchedStat_WaitHistogram		8
+#define SchedStat_RunHistogram		(SchedStat_WaitHistogram + SchedStatBuckets)
+#define SchedStatSize			(SchedStat_RunHistogram + SchedStatBuckets)
+
+#define SysCall_Mmap		22
+#define SysCall_Munmap		23
+
+#define SysCall_RingSetup	24
+#define SysCall_RingEnter	25
+
+#define SyscallRingSize		16	/* slots in each half of a system
+					 * call ring; a power of two */
+
+#define SysCall_GetMemStats	26
+
+/* Layout of the buffer filled in by GetMemStats, for the calling
+ * process.  Sizes are in pages of MemStat_PageSize bytes.  Pages shared
+ * with other processes (code, and pages shared copy-on-write after a
+ * Fork) count in full for each of them.
+ */
+#define MemStat_PageSize		0
+#define MemStat_VirtualPages		1	/* including mapped files */
+#define MemStat_ResidentPages		2	/* in memory now */
+#define MemStat_PeakResident		3
+#define MemStat_SwapPages		4	/* held in swap slots */
+#define MemStat_PageFaults		5	/* that brought a page in */
+#define MemStat_PageIns			6	/* faults served from swap */
+#define MemStat_PageOuts		7	/* dirty pages written on
+						 * eviction */
+#define MemStatSize			8
+
+#define SysCall_Checkpoint	27
+#define SysCall_Restore		28
+
 #define SysCall_NumInstr	50
 
+#define NumSysCalls		(SysCall_NumInstr + 1)	/* size of the kernel's
+							 * system call table */
+
 #ifndef IN_ASM
 
 /* The system call interface.  These are the operations the Nachos
@@ -74,12 +127,16 @@ void syscall_wrapper_Exit(int status);
 /* This is same as PID. */
 typedef int SpaceId;	
  
-/* Run the executable, stored in the Nachos file "name"
+/* Run the executable, stored in the Nachos file "name", in place of
+ * the calling program.  Only returns, with -1, if "name" can't be
+ * opened or isn't a program that can be run; the caller then carries
+ * on as it was.
  */
-void syscall_wrapper_Exec(char *name);
+int syscall_wrapper_Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status, or -1 if "id" isn't a child of the caller
+ * (or has already been joined).
  */
 int syscall_wrapper_Join(SpaceId id); 	
  
@@ -127,6 +184,68 @@ int syscall_wrapper_Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void syscall_wrapper_Close(OpenFileId id);
 
+/* Map the first "length" bytes of the open file into memory, and return
+ * the address of the mapping (or -1).  Pages are read from the file as
+ * they are touched; the file need not stay open.
+ */
+char *syscall_wrapper_Mmap(OpenFileId id, int length);
+
+/* Unmap the mapping at "addr", writing any changes back to the file.
+ * Returns 0, or -1 if there is no mapping at "addr".  Mappings are
+ * also undone when the program exits.
+ */
+int syscall_wrapper_Munmap(char *addr);
+
+
+/* Batched system calls.  A program can queue up system calls in a ring
+ * in its own memory, and have the kernel carry out a whole batch of them
+ * for the price of one trap: the ring is drained by RingEnter, and also
+ * on the way into any other system call, so a program that makes system
+ * calls anyway need not trap for the ring at all.  Read, Write, Yield
+ * and Sleep can be queued.  Requests are carried out in order, and each
+ * produces one completion carrying the request's tag and the call's
+ * result.
+ *
+ * The head and tail counters run freely; slot i is i % SyscallRingSize.
+ * The program only writes requests, submitTail and completionHead; the
+ * kernel only writes completions, submitHead and completionTail.  The
+ * kernel stops taking requests while the completion half is full.
+ */
+
+typedef struct {
+    int code;			/* SysCall_Read, SysCall_Write, ... */
+    int arg1, arg2, arg3;	/* as they would be passed in r4..r6 */
+    int tag;			/* copied into the completion */
+} SyscallRingRequest;
+
+typedef struct {
+    int tag;
+    int result;			/* what the system call returned, or -1
+				 * if it can't be queued */
+} SyscallRingCompletion;
+
+typedef struct {
+    int submitHead;		/* next request the kernel takes */
+    int submitTail;		/* next free request slot */
+    int completionHead;		/* next completion the program takes */
+    int completionTail;		/* next free completion slot */
+    SyscallRingRequest requests[SyscallRingSize];
+    SyscallRingCompletion completions[SyscallRingSize];
+} SyscallRing;
+
+/* Register "ring" (word aligned) for this address space, resetting its
+ * counters, or unregister it if "ring" is 0.  Returns 0, or -1 if the
+ * ring isn't aligned or doesn't lie wholly in writable memory: the data
+ * and stack of the program, or a mapped file.  A forked child starts
+ * with no ring, and unmapping the file a ring lies in unregisters it.
+ */
+int syscall_wrapper_RingSetup(SyscallRing *ring);
+
+/* Carry out the requests in the ring.  Returns how many were done, or -1
+ * if the ring is no longer valid, in which case it is unregistered.
+ */
+int syscall_wrapper_RingEnter(void);
+
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
@@ -160,12 +279,42 @@ int syscall_wrapper_GetPID (void);
 
 int syscall_wrapper_GetPPID (void);
 
-void syscall_wrapper_Sleep (unsigned);
+/* Sleep for at least "ticks"; Sleep(0) just yields.  Returns how many
+ * ticks late the caller got the CPU back.
+ */
+int syscall_wrapper_Sleep (unsigned ticks);
 
+/* The current simulated time, in ticks. */
 int syscall_wrapper_GetTime (void);
 
 int syscall_wrapper_GetNumInstr (void);
 
+/* Copy scheduler statistics into "buffer", which holds "size" ints.
+ * Returns the number of ints copied.  See SchedStat_* for the layout.
+ */
+int syscall_wrapper_SchedStats (int *buffer, int size);
+
+/* Copy the calling process's memory usage into "buffer", which holds
+ * "size" ints.  Returns the number of ints copied.  See MemStat_* for
+ * the layout.
+ */
+int syscall_wrapper_GetMemStats (int *buffer, int size);
+
+/* Save the calling process in the file "name", so that it can carry on
+ * from here later, even after Nachos is restarted.  Returns 0 once the
+ * checkpoint is taken, 1 when the process is resumed from it by
+ * Restore, and -1 on error.  Only the pages written since the last
+ * checkpoint to the same file are saved again.
+ */
+int syscall_wrapper_Checkpoint (char *name);
+
+/* Replace the calling process with the one saved in the checkpoint
+ * "name", which resumes by returning 1 from Checkpoint.  Returns -1,
+ * and doesn't replace anything, if "name" isn't a checkpoint that can
+ * be restored, for instance because its program has gone.
+ */
+int syscall_wrapper_Restore (char *name);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
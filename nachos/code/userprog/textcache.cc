@@ -0,0 +1,112 @@
+// textcache.cc 
+//	Routines to share the code pages of an executable between the
+//	address spaces running it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "textcache.h"
+
+//----------------------------------------------------------------------
+// TextPageCache::TextPageCache
+// 	Initialize an empty cache.
+//
+//	"frameCount" is the number of physical page frames in mainMemory.
+//----------------------------------------------------------------------
+
+TextPageCache::TextPageCache(int frameCount)
+{
+    int i;
+
+    numFrames = frameCount;
+    fileNames = new char *[numFrames];
+    offsets = new int[numFrames];
+    for (i = 0; i < numFrames; i++) {
+	fileNames[i] = NULL;
+	offsets[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// TextPageCache::~TextPageCache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+TextPageCache::~TextPageCache()
+{
+    int i;
+
+    for (i = 0; i < numFrames; i++)
+	delete [] fileNames[i];
+    delete [] fileNames;
+    delete [] offsets;
+}
+
+//----------------------------------------------------------------------
+// TextPageCache::Lookup
+// 	Find the frame caching the page at "offset" in the executable
+//	"fileName", and take a reference to it on behalf of the caller.
+//
+//	Returns the frame number, or -1 if the page isn't cached.
+//----------------------------------------------------------------------
+
+int
+TextPageCache::Lookup(char *fileName, int offset)
+{
+    int frame;
+
+    for (frame = 0; frame < numFrames; frame++)
+	if (fileNames[frame] != NULL && offsets[frame] == offset
+		&& !strcmp(fileNames[frame], fileName)) {
+	    frameAllocator->ShareFrame(frame);
+	    DEBUG('a', "Text page %s:%d found in frame %d\n", fileName,
+		  offset, frame);
+	    return frame;
+	}
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// TextPageCache::Insert
+// 	Enter a freshly loaded code page in the cache.  The cache keeps
+//	its own reference to "frame", on top of the caller's.
+//----------------------------------------------------------------------
+
+void
+TextPageCache::Insert(char *fileName, int offset, int frame)
+{
+    ASSERT(fileNames[frame] == NULL);
+    fileNames[frame] = new char[strlen(fileName) + 1];
+    strcpy(fileNames[frame], fileName);
+    offsets[frame] = offset;
+    frameAllocator->ShareFrame(frame);
+}
+
+//----------------------------------------------------------------------
+// TextPageCache::Release
+// 	An address space is done with "frame".  If it is a cached page,
+//	drop that reference, and once the cache is the only one left
+//	holding the frame, forget the page and free the frame.
+//
+//	Returns FALSE (and does nothing) if "frame" isn't a cached page,
+//	in which case the caller should free it itself.
+//----------------------------------------------------------------------
+
+bool
+TextPageCache::Release(int frame)
+{
+    if (fileNames[frame] == NULL)
+	return FALSE;
+    frameAllocator->FreeFrame(frame);
+    if (frameAllocator->RefCount(frame) == 1) {
+	DEBUG('a', "Text page %s:%d no longer in use, freeing frame %d\n",
+	      fileNames[frame], offsets[frame], frame);
+	delete [] fileNames[frame];
+	fileNames[frame] = NULL;
+	frameAllocator->FreeFrame(frame);
+    }
+    return TRUE;
+}
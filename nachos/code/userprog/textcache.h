@@ -0,0 +1,59 @@
+// textcache.h 
+//	Data structures for sharing the code pages of an executable
+//	between every process running it.
+//
+//	Code pages are never written, so there is no need for each
+//	address space to read in and hold its own copy.  The first
+//	process to touch a code page loads it into a frame and enters
+//	it here, keyed by the executable's name and the page's offset
+//	in the file; later processes running the same binary just map
+//	that frame read-only.  The cache holds a reference to each frame
+//	it knows about, and lets go once no address space maps it any
+//	more.
+//
+//	Under VM, cached frames are in the core map like any other, and
+//	the replacement policy may pick one.  A code page is never dirty,
+//	so evicting it just takes it away from every page mapping it;
+//	the last one to let go frees the frame, as on exit.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "copyright.h"
+
+// The following class defines the text page cache.  There is at most
+// one cached page per physical frame, so the cache is simply a table
+// indexed by frame number.
+
+class TextPageCache {
+  public:
+    TextPageCache(int frameCount);	// Initialize an empty cache
+    ~TextPageCache();			// De-allocate the cache
+
+    int Lookup(char *fileName, int offset);
+					// Return the frame holding the page
+					// at "offset" in "fileName", with
+					// one more reference to it; -1 if
+					// it isn't cached
+    void Insert(char *fileName, int offset, int frame);
+					// Remember that "frame" holds the
+					// page at "offset" in "fileName"
+    bool Release(int frame);		// Drop an address space's mapping of
+					// "frame", if it is a cached page;
+					// FALSE if it isn't one
+    bool Holds(int frame) { return fileNames[frame] != NULL; }
+					// Is "frame" a cached page?
+
+  private:
+    int numFrames;			// size of the table
+    char **fileNames;			// for each frame, the executable it
+					// caches a page of, or NULL
+    int *offsets;			// for each frame, the offset of that
+					// page in the executable
+};
+
+#endif // TEXTCACHE_H
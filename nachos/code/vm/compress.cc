@@ -0,0 +1,132 @@
+// compress.cc 
+//	Routines to compress and decompress pages.  See compress.h for
+//	the format.
+//
+//	The compressor is greedy: at each position it looks up the last
+//	place the next MinMatch bytes were seen, in a small hash table,
+//	and takes the match there if there is one.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "utility.h"
+#include "compress.h"
+
+#define HashBits	12		// log2 of the hash table size
+#define MaxDistance	65535		// farthest back a match can reach
+
+//----------------------------------------------------------------------
+// HashPrefix
+// 	Hash the MinMatch bytes at "p".
+//----------------------------------------------------------------------
+
+static int
+HashPrefix(unsigned char *p)
+{
+    unsigned int key = (p[0] << 16) | (p[1] << 8) | p[2];
+
+    return (int) ((key * 2654435761u) >> (32 - HashBits));
+}
+
+//----------------------------------------------------------------------
+// FlushLiterals
+// 	Emit the literal run "from[start..end)" at "to[out]", in pieces
+//	of at most MaxLiterals bytes.  Returns the new output position.
+//----------------------------------------------------------------------
+
+static int
+FlushLiterals(unsigned char *from, int start, int end, unsigned char *to,
+	      int out)
+{
+    int n;
+
+    while (start < end) {
+	n = min(end - start, MaxLiterals);
+	to[out++] = n - 1;
+	bcopy(&from[start], &to[out], n);
+	out += n;
+	start += n;
+    }
+    return out;
+}
+
+//----------------------------------------------------------------------
+// Compress
+// 	Compress the "size" bytes at "from" into "to", which must have
+//	room for CompressBound(size) bytes.
+//
+//	Returns the number of bytes written to "to".
+//----------------------------------------------------------------------
+
+int
+Compress(char *from, int size, char *to)
+{
+    unsigned char *in = (unsigned char *) from;
+    unsigned char *out = (unsigned char *) to;
+    int table[1 << HashBits];
+    int pos = 0, literalStart = 0, outPos = 0;
+    int h, candidate, length, distance, i;
+
+    for (i = 0; i < (1 << HashBits); i++)
+	table[i] = -1;
+    while (pos + MinMatch <= size) {
+	h = HashPrefix(&in[pos]);
+	candidate = table[h];
+	table[h] = pos;
+	if ((candidate == -1) || (pos - candidate > MaxDistance)
+		|| bcmp(&in[candidate], &in[pos], MinMatch)) {
+	    pos++;
+	    continue;
+	}
+	length = MinMatch;
+	while ((pos + length < size) && (length < MaxMatch)
+		&& (in[candidate + length] == in[pos + length]))
+	    length++;
+	outPos = FlushLiterals(in, literalStart, pos, out, outPos);
+	distance = pos - candidate;
+	out[outPos++] = 128 + (length - MinMatch);
+	out[outPos++] = distance >> 8;
+	out[outPos++] = distance & 0xff;
+	pos += length;
+	literalStart = pos;
+    }
+    return FlushLiterals(in, literalStart, size, out, outPos);
+}
+
+//----------------------------------------------------------------------
+// Decompress
+// 	Expand the "compressedSize" bytes at "from", made by Compress,
+//	into the "size" bytes they came from, at "to".
+//----------------------------------------------------------------------
+
+void
+Decompress(char *from, int compressedSize, char *to, int size)
+{
+    unsigned char *in = (unsigned char *) from;
+    unsigned char *out = (unsigned char *) to;
+    int inPos = 0, outPos = 0;
+    int tag, n, distance;
+
+    while (inPos < compressedSize) {
+	tag = in[inPos++];
+	if (tag < 128) {
+	    n = tag + 1;
+	    ASSERT(outPos + n <= size);
+	    bcopy(&in[inPos], &out[outPos], n);
+	    inPos += n;
+	} else {
+	    n = (tag - 128) + MinMatch;
+	    distance = (in[inPos] << 8) | in[inPos + 1];
+	    inPos += 2;
+	    ASSERT((distance > 0) && (distance <= outPos)
+		   && (outPos + n <= size));
+	    for (; n > 0; n--, outPos++)	// byte by byte, since the
+		out[outPos] = out[outPos - distance];	// copy may overlap
+	    continue;
+	}
+	outPos += n;
+    }
+    ASSERT(outPos == size);
+}
@@ -0,0 +1,37 @@
+// compress.h 
+//	A small, fast LZ77-style codec for pages going into the
+//	compressed swap cache.
+//
+//	The compressed form is a series of items, each starting with a
+//	tag byte.  A tag below 128 is followed by tag + 1 literal bytes.
+//	A tag of 128 or more is a match: (tag - 128) + MinMatch bytes
+//	copied from earlier in the output, at a distance given by the two
+//	bytes that follow, high byte first.  Matches may overlap the bytes
+//	they produce, so a run of zeroes costs a few bytes per 130.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include "copyright.h"
+
+#define MinMatch	3		// shortest match worth encoding
+#define MaxMatch	(127 + MinMatch)	// longest one a tag can hold
+#define MaxLiterals	128		// longest literal run
+
+#define CompressBound(size)	((size) + (size) / 4 + 2)
+					// most the compressed form of
+					// "size" bytes can take: one literal
+					// and a shortest match, over and over
+
+extern int Compress(char *from, int size, char *to);
+					// Compress "size" bytes; returns the
+					// compressed size
+extern void Decompress(char *from, int compressedSize, char *to, int size);
+					// Undo Compress, producing exactly
+					// "size" bytes
+
+#endif // COMPRESS_H
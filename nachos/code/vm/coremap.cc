@@ -0,0 +1,326 @@
+// coremap.cc 
+//	Routines to keep track of the pages mapping physical frames, and
+//	to choose and evict frames.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "coremap.h"
+
+//----------------------------------------------------------------------
+// CoreMap::CoreMap
+// 	Initialize the core map, with no frame evictable.
+//
+//	"frameCount" is the number of physical page frames in mainMemory.
+//	"replacementPolicy" is how to choose a frame to evict.
+//----------------------------------------------------------------------
+
+CoreMap::CoreMap(int frameCount, ReplacementPolicy replacementPolicy)
+{
+    int i;
+
+    numFrames = frameCount;
+    policy = replacementPolicy;
+    mappings = new FrameMapping *[numFrames];
+    pinned = new bool[numFrames];
+    loadTimes = new int[numFrames];
+    lastUses = new int[numFrames];
+    for (i = 0; i < numFrames; i++) {
+	mappings[i] = NULL;
+	pinned[i] = FALSE;
+	loadTimes[i] = lastUses[i] = 0;
+    }
+    nextLoad = 0;
+    hand = 0;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::~CoreMap
+// 	De-allocate the core map.
+//----------------------------------------------------------------------
+
+CoreMap::~CoreMap()
+{
+    FrameMapping *m;
+    int i;
+
+    for (i = 0; i < numFrames; i++)
+	while (mappings[i] != NULL) {
+	    m = mappings[i];
+	    mappings[i] = m->next;
+	    delete m;
+	}
+    delete [] mappings;
+    delete [] pinned;
+    delete [] loadTimes;
+    delete [] lastUses;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::MapFrame
+// 	Note that virtual page "vpn" of "space" maps "frame", so that it
+//	is evicted along with the frame.  A frame nobody mapped before
+//	counts as freshly loaded.  Does nothing if the page is already
+//	noted.
+//----------------------------------------------------------------------
+
+void
+CoreMap::MapFrame(int frame, ProcessAddressSpace *space, int vpn)
+{
+    FrameMapping *m;
+
+    for (m = mappings[frame]; m != NULL; m = m->next)
+	if ((m->space == space) && (m->vpn == vpn))
+	    return;
+    if (mappings[frame] == NULL) {
+	loadTimes[frame] = nextLoad++;
+	lastUses[frame] = stats->totalTicks;
+    }
+    m = new FrameMapping;
+    m->space = space;
+    m->vpn = vpn;
+    m->next = mappings[frame];
+    mappings[frame] = m;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::UnmapFrame
+// 	Virtual page "vpn" of "space" is letting go of "frame".  Does
+//	nothing if it wasn't noted as mapping it.
+//----------------------------------------------------------------------
+
+void
+CoreMap::UnmapFrame(int frame, ProcessAddressSpace *space, int vpn)
+{
+    FrameMapping **prev, *m;
+
+    for (prev = &mappings[frame]; *prev != NULL; prev = &((*prev)->next)) {
+	m = *prev;
+	if ((m->space == space) && (m->vpn == vpn)) {
+	    *prev = m->next;
+	    delete m;
+	    return;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// CoreMap::EvictFrame
+// 	Evict every page mapping "frame", so that the frame is freed.
+//	Pages sharing the frame have the same contents, so if it has to
+//	be saved, the first page that needs it written to swap does so,
+//	and the others share its swap slot (see EvictPage).
+//----------------------------------------------------------------------
+
+void
+CoreMap::EvictFrame(int frame)
+{
+    FrameMapping *m;
+    int slot = -1;
+
+    while (mappings[frame] != NULL) {
+	m = mappings[frame];
+	slot = m->space->EvictPage(m->vpn, slot);
+	ASSERT(mappings[frame] != m);	// EvictPage unmaps the page
+    }
+}
+
+//----------------------------------------------------------------------
+// CoreMap::Owner, CoreMap::VirtualPage
+// 	Return the address space and virtual page mapping "frame", if
+//	exactly one page maps it; NULL (or -1) otherwise.
+//----------------------------------------------------------------------
+
+ProcessAddressSpace *
+CoreMap::Owner(int frame)
+{
+    if ((mappings[frame] == NULL) || (mappings[frame]->next != NULL))
+	return NULL;
+    return mappings[frame]->space;
+}
+
+int
+CoreMap::VirtualPage(int frame)
+{
+    if ((mappings[frame] == NULL) || (mappings[frame]->next != NULL))
+	return -1;
+    return mappings[frame]->vpn;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::ChooseVictim
+// 	Pick a frame to evict, according to the replacement policy.  The
+//	caller evicts it, with EvictFrame.
+//
+//	Returns the frame, or -1 if no frame can be evicted.
+//----------------------------------------------------------------------
+
+int
+CoreMap::ChooseVictim()
+{
+    int frame;
+
+    switch (policy) {
+      case FIFOReplacement:
+	frame = ChooseFIFO();
+	break;
+      case RandomReplacement:
+	frame = ChooseRandom();
+	break;
+      case ClockReplacement:
+	frame = ChooseClock();
+	break;
+      default:
+	frame = ChooseWorkingSet();
+	break;
+    }
+    if (frame != -1)
+	DEBUG('v', "Evicting frame %d, page %d%s\n", frame,
+	      mappings[frame]->vpn,
+	      (mappings[frame]->next != NULL) ? " and others" : "");
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::ChooseFIFO
+// 	Pick the evictable frame that was mapped longest ago.
+//----------------------------------------------------------------------
+
+int
+CoreMap::ChooseFIFO()
+{
+    int i, victim = -1;
+
+    for (i = 0; i < numFrames; i++)
+	if (Evictable(i) && ((victim == -1) || (loadTimes[i] < loadTimes[victim])))
+	    victim = i;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::ChooseRandom
+// 	Pick an evictable frame at random: start looking at a random
+//	frame, and take the first evictable one from there on.
+//----------------------------------------------------------------------
+
+int
+CoreMap::ChooseRandom()
+{
+    int i, start = Random() % numFrames;
+
+    for (i = 0; i < numFrames; i++)
+	if (Evictable((start + i) % numFrames))
+	    return (start + i) % numFrames;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::ChooseClock
+// 	Sweep the clock hand over the frames, giving each frame that has
+//	been used since the last sweep a second chance (and clearing its
+//	use bit), and stopping at the first one that hasn't.
+//----------------------------------------------------------------------
+
+int
+CoreMap::ChooseClock()
+{
+    int i, frame;
+
+    for (i = 0; i < 2 * numFrames; i++) {	// two sweeps clear every bit
+	frame = hand;
+	hand = (hand + 1) % numFrames;
+	if (!Evictable(frame))
+	    continue;
+	if (!TestAndClearUse(frame))
+	    return frame;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::ChooseWorkingSet
+// 	Approximate the working set of each process with the use bits:
+//	a frame whose use bit is set was used since the last scan, so
+//	note the time and clear the bit.  Evict the first frame not used
+//	within the last WorkingSetWindow ticks; if every frame is in some
+//	working set, evict the least recently used one.
+//
+//	Load control samples the same use bits, keeping the time in the
+//	page tables, so the later of the two times is taken.
+//----------------------------------------------------------------------
+
+int
+CoreMap::ChooseWorkingSet()
+{
+    int i, frame, victim = -1;
+
+    for (i = 0; i < numFrames; i++) {
+	frame = (hand + i) % numFrames;
+	if (!Evictable(frame))
+	    continue;
+	lastUses[frame] = max(lastUses[frame], LastUse(frame));
+	if ((victim == -1) || (lastUses[frame] < lastUses[victim]))
+	    victim = frame;
+	if (stats->totalTicks - lastUses[frame] > WorkingSetWindow) {
+	    victim = frame;
+	    break;
+	}
+    }
+    if (victim != -1)
+	hand = (victim + 1) % numFrames;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::Evictable
+// 	A frame can be evicted if some page maps it, and the kernel isn't
+//	in the middle of using it.
+//----------------------------------------------------------------------
+
+bool
+CoreMap::Evictable(int frame)
+{
+    return (mappings[frame] != NULL) && !pinned[frame];
+}
+
+//----------------------------------------------------------------------
+// CoreMap::TestAndClearUse
+// 	Return TRUE if any page mapping "frame" has its use bit set, and
+//	clear them all, for the clock's next sweep.
+//----------------------------------------------------------------------
+
+bool
+CoreMap::TestAndClearUse(int frame)
+{
+    TranslationEntry *entry;
+    FrameMapping *m;
+    bool used = FALSE;
+
+    for (m = mappings[frame]; m != NULL; m = m->next) {
+	entry = m->space->GetPageTableEntry(m->vpn);
+	if (entry->use) {
+	    used = TRUE;
+	    entry->use = FALSE;
+	}
+    }
+    return used;
+}
+
+//----------------------------------------------------------------------
+// CoreMap::LastUse
+// 	Return the last time any page mapping "frame" was seen in use.
+//----------------------------------------------------------------------
+
+int
+CoreMap::LastUse(int frame)
+{
+    FrameMapping *m;
+    int when = lastUses[frame];
+
+    for (m = mappings[frame]; m != NULL; m = m->next)
+	when = max(when, m->space->LastUse(m->vpn));
+    return when;
+}
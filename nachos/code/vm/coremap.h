@@ -0,0 +1,93 @@
+// coremap.h 
+//	Data structures to keep track of which virtual pages each physical
+//	frame holds, and to pick a frame to evict when memory is full.
+//
+//	A frame can be mapped by several pages at once: pages shared
+//	copy-on-write after a Fork, and pages merged by the page merger.
+//	The core map keeps every mapping of each frame, so that evicting
+//	a frame takes it away from all of its pages together, and the
+//	policies see a frame as used if any of them used it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef COREMAP_H
+#define COREMAP_H
+
+#include "copyright.h"
+#include "translate.h"
+
+class ProcessAddressSpace;
+
+// The page replacement policies, selected with -vmpolicy.
+
+enum ReplacementPolicy {
+    FIFOReplacement,			// evict the page loaded longest ago
+    RandomReplacement,			// evict any page
+    ClockReplacement,			// second chance, using the use bit
+    WorkingSetReplacement		// evict a page outside the working
+					// set, or else the least recently
+					// used one
+};
+
+#define WorkingSetWindow	2000	// ticks a page stays in the working
+					// set after its last use
+
+// A page mapping a frame.  Each frame has a list of them.
+
+struct FrameMapping {
+    ProcessAddressSpace *space;		// Address space of the page
+    int vpn;				// ... and its virtual page number
+    FrameMapping *next;			// Next page mapping the same frame
+};
+
+// The following class defines the core map: for each physical frame,
+// the pages that map it, along with what the replacement policies need
+// to know.  A frame no page maps, or that is pinned, can't be evicted.
+
+class CoreMap {
+  public:
+    CoreMap(int frameCount, ReplacementPolicy replacementPolicy);
+					// Initialize, with no evictable frames
+    ~CoreMap();				// De-allocate the core map
+
+    void MapFrame(int frame, ProcessAddressSpace *space, int vpn);
+					// Page "vpn" of "space" now maps
+					// "frame", which may be evicted
+    void UnmapFrame(int frame, ProcessAddressSpace *space, int vpn);
+					// ... and now no longer does
+    void PinFrame(int frame) { pinned[frame] = TRUE; }
+    void UnpinFrame(int frame) { pinned[frame] = FALSE; }
+					// Keep "frame" from being evicted
+					// while the kernel copies it
+
+    int ChooseVictim();			// Pick a frame to evict; -1 if none
+    void EvictFrame(int frame);		// Evict every page mapping "frame"
+    ProcessAddressSpace *Owner(int frame);
+					// The only address space mapping
+					// "frame", or NULL
+    int VirtualPage(int frame);		// ... and the page mapping it
+
+  private:
+    int numFrames;
+    ReplacementPolicy policy;
+    FrameMapping **mappings;		// Pages mapping each frame
+    bool *pinned;			// Frames that can't be evicted now
+    int *loadTimes;			// When each frame was mapped (FIFO)
+    int *lastUses;			// When each frame was last seen in
+					// use (working set)
+    int nextLoad;			// Counter for loadTimes
+    int hand;				// Clock hand
+
+    bool Evictable(int frame);		// Can "frame" be evicted?
+    bool TestAndClearUse(int frame);	// Did any page use "frame" since
+					// the last look?
+    int LastUse(int frame);		// When a page last used "frame"
+    int ChooseFIFO();			// One routine per policy
+    int ChooseRandom();
+    int ChooseClock();
+    int ChooseWorkingSet();
+};
+
+#endif // COREMAP_H
@@ -0,0 +1,302 @@
+// loadcontrol.cc 
+//	Routines to admit, suspend and resume processes according to
+//	how much memory their working sets need.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "loadcontrol.h"
+
+#define InitialCapacity	8		// entries to start with
+
+//----------------------------------------------------------------------
+// LoadControl::LoadControl
+// 	Initialize load control, with no processes.
+//
+//	"frameCount" is the number of frames user programs may use.
+//----------------------------------------------------------------------
+
+LoadControl::LoadControl(int frameCount)
+{
+    numFrames = frameCount;
+    capacity = InitialCapacity;
+    entries = new LoadEntry[capacity];
+    numEntries = 0;
+    totalWorkingSet = 0;
+    lastEstimate = 0;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::~LoadControl
+// 	De-allocate load control.  Waiting processes are never let in.
+//----------------------------------------------------------------------
+
+LoadControl::~LoadControl()
+{
+    delete [] entries;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Admit
+// 	The current thread is about to start running the program in
+//	"space".  If there is room for another AdmissionPages frames of
+//	working set, or nothing else is running, it goes straight in;
+//	otherwise it waits its turn.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Admit(ProcessAddressSpace *space)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    Estimate(FALSE);
+    Add(space, AdmissionPages);
+    ResumeWaiting();
+    if (entries[numEntries - 1].waiting) {
+	DEBUG('v', "Load control: delaying \"%s\", working sets %d of %d "
+	      "frames\n", currentThread->getName(), totalWorkingSet,
+	      numFrames);
+	stats->numLoadDelays++;
+	Wait(numEntries - 1);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Leave
+// 	"space" is being deleted, so its frames are about to be free.
+//	Forget it, and let in whoever now fits.  Does nothing if "space"
+//	was never admitted.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Leave(ProcessAddressSpace *space)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int i = Find(space);
+
+    if (i != -1) {
+	for (; i < numEntries - 1; i++)
+	    entries[i] = entries[i + 1];
+	numEntries--;
+	Estimate(TRUE);
+	ResumeWaiting();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// LoadControl::CheckPressure
+// 	Called by the current thread on a page fault in "space".  If the
+//	running processes' working sets no longer fit in memory, and
+//	"space" is the one admitted most recently, suspend it until they
+//	do again, so that the others can keep their pages.  Otherwise,
+//	take the chance to let in waiting processes that now fit.
+//----------------------------------------------------------------------
+
+void
+LoadControl::CheckPressure(ProcessAddressSpace *space)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int i = Find(space), last;
+
+    if (i == -1) {
+	(void) interrupt->SetLevel(oldLevel);
+	return;
+    }
+    Estimate(FALSE);
+    for (last = numEntries - 1; entries[last].waiting; last--)
+	;
+    if ((totalWorkingSet > numFrames) && (NumRunning() > 1) && (last == i)) {
+	entries[i].needed = max(space->WorkingSetSize(), 1);
+	entries[i].waiting = TRUE;
+	totalWorkingSet -= entries[i].needed;
+	DEBUG('v', "Load control: suspending \"%s\" (working set %d), "
+	      "working sets %d of %d frames\n", currentThread->getName(),
+	      entries[i].needed, totalWorkingSet + entries[i].needed,
+	      numFrames);
+	stats->numLoadSuspensions++;
+	Wait(i);
+    } else
+	ResumeWaiting();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Balance
+// 	Let in waiting processes that fit, now that the working sets of
+//	the running ones may have shrunk; a process blocked on something
+//	else does no paging, and so never calls CheckPressure.  Called
+//	with interrupts disabled, from the timer interrupt handler.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Balance()
+{
+    if (numEntries > NumRunning()) {
+	Estimate(FALSE);
+	ResumeWaiting();
+    }
+}
+
+//----------------------------------------------------------------------
+// LoadControl::ResumeIdle
+// 	Called when there is nothing to run.  Waiting for memory to free
+//	up would then wait forever, so let the first waiting process in
+//	regardless.
+//
+//	Returns TRUE if a process was let in.
+//----------------------------------------------------------------------
+
+bool
+LoadControl::ResumeIdle()
+{
+    int i;
+
+    for (i = 0; i < numEntries; i++)
+	if (entries[i].waiting) {
+	    DEBUG('v', "Load control: idle, resuming \"%s\"\n",
+		  entries[i].thread->getName());
+	    totalWorkingSet += entries[i].needed;
+	    Resume(i);
+	    return TRUE;
+	}
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Find
+// 	Return the index of the entry for "space", or -1 if there is
+//	none.
+//----------------------------------------------------------------------
+
+int
+LoadControl::Find(ProcessAddressSpace *space)
+{
+    int i;
+
+    for (i = 0; i < numEntries; i++)
+	if (entries[i].space == space)
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Add
+// 	Append an entry for "space", run by the current thread, waiting
+//	to be let in with "needed" frames.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Add(ProcessAddressSpace *space, int needed)
+{
+    LoadEntry *oldEntries;
+    int i;
+
+    if (numEntries == capacity) {
+	oldEntries = entries;
+	capacity *= 2;
+	entries = new LoadEntry[capacity];
+	for (i = 0; i < numEntries; i++)
+	    entries[i] = oldEntries[i];
+	delete [] oldEntries;
+    }
+    entries[numEntries].space = space;
+    entries[numEntries].thread = currentThread;
+    entries[numEntries].waiting = TRUE;
+    entries[numEntries].needed = needed;
+    numEntries++;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Wait
+// 	Put the current thread, entry "i", to sleep until Resume lets it
+//	in.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Wait(int i)
+{
+    ASSERT(entries[i].thread == currentThread);
+    currentThread->PutThreadToSleep();
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Resume
+// 	Let entry "i" run.  Its thread is woken, unless it is the current
+//	thread, which hasn't gone to sleep yet.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Resume(int i)
+{
+    entries[i].waiting = FALSE;
+    if (entries[i].thread != currentThread)
+	scheduler->MoveThreadToReadyQueue(entries[i].thread);
+}
+
+//----------------------------------------------------------------------
+// LoadControl::NumRunning
+// 	Return the number of entries that aren't waiting.
+//----------------------------------------------------------------------
+
+int
+LoadControl::NumRunning()
+{
+    int i, running = 0;
+
+    for (i = 0; i < numEntries; i++)
+	if (!entries[i].waiting)
+	    running++;
+    return running;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::Estimate
+// 	Add up the working sets of the running processes, if the last
+//	estimate is more than LoadControlInterval ticks old, or "force"
+//	is set.
+//----------------------------------------------------------------------
+
+void
+LoadControl::Estimate(bool force)
+{
+    int i;
+
+    if (!force && (stats->totalTicks - lastEstimate < LoadControlInterval))
+	return;
+    totalWorkingSet = 0;
+    for (i = 0; i < numEntries; i++)
+	if (!entries[i].waiting)
+	    totalWorkingSet += entries[i].space->WorkingSetSize();
+    lastEstimate = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// LoadControl::ResumeWaiting
+// 	Let waiting processes in, oldest first, for as long as the next
+//	one's working set fits in the frames left over.
+//	If nothing is running, the first one is let in whatever it needs.
+//----------------------------------------------------------------------
+
+void
+LoadControl::ResumeWaiting()
+{
+    int i;
+
+    for (i = 0; i < numEntries; i++) {
+	if (!entries[i].waiting)
+	    continue;
+	if ((NumRunning() > 0)
+		&& (totalWorkingSet + entries[i].needed > numFrames))
+	    break;
+	DEBUG('v', "Load control: resuming \"%s\" (needs %d), working sets "
+	      "%d of %d frames\n", entries[i].thread->getName(),
+	      entries[i].needed, totalWorkingSet, numFrames);
+	totalWorkingSet += entries[i].needed;
+	Resume(i);
+    }
+}
@@ -0,0 +1,92 @@
+// loadcontrol.h 
+//	Data structures for load control: keeping the working sets of
+//	the processes competing for memory within the physical frames,
+//	so that they don't keep evicting each other's pages.
+//
+//	Each process is admitted when it starts running a program, and
+//	leaves when its address space goes away.  While the working sets
+//	of the running processes add up to more frames than there are, the
+//	most recently admitted one is suspended at its next page fault,
+//	and new processes wait to be admitted.  They are let in again,
+//	oldest first, as processes exit or their working sets shrink.
+//	One process is always allowed to run.
+//
+//	The working sets are estimated from the use bits of the page
+//	tables (see ProcessAddressSpace::WorkingSetSize), at most once
+//	every LoadControlInterval ticks.
+//
+//	Everything is done with interrupts disabled, since waiting
+//	processes are also let in from the timer interrupt handler.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LOADCONTROL_H
+#define LOADCONTROL_H
+
+#include "copyright.h"
+
+class ProcessAddressSpace;
+class NachOSThread;
+
+#define LoadControlInterval	500	// ticks between working set
+					// estimates
+#define AdmissionPages		8	// frames a process is assumed to
+					// need when it starts
+
+// One process known to load control.
+
+struct LoadEntry {
+    ProcessAddressSpace *space;		// its address space
+    NachOSThread *thread;		// the thread running it
+    bool waiting;			// TRUE if suspended, or not yet
+					// admitted
+    int needed;				// frames it needs to be let in:
+					// its working set when suspended
+};
+
+// The following class defines load control.
+
+class LoadControl {
+  public:
+    LoadControl(int frameCount);	// Initialize, with no processes
+    ~LoadControl();			// De-allocate load control
+
+    void Admit(ProcessAddressSpace *space);
+					// The current thread is about to
+					// run "space"; wait until it fits
+    void Leave(ProcessAddressSpace *space);
+					// "space" is going away
+    void CheckPressure(ProcessAddressSpace *space);
+					// Called on a page fault in "space";
+					// suspend it if memory is overcommitted
+    void Balance();			// Let waiting processes in if they
+					// fit; from the timer interrupt
+    bool ResumeIdle();			// Nothing can run: let the first
+					// waiting process in, if any
+
+  private:
+    int numFrames;			// frames to share out
+    LoadEntry *entries;			// the processes, in the order they
+					// were admitted
+    int numEntries, capacity;
+    int totalWorkingSet;		// sum of the running processes'
+					// working sets, at the last estimate
+    int lastEstimate;			// when that was
+
+    int Find(ProcessAddressSpace *space);
+					// Index of "space", or -1
+    void Add(ProcessAddressSpace *space, int needed);
+					// Append a waiting entry for the
+					// current thread
+    void Wait(int i);			// Suspend the current thread, which
+					// is entry "i", until it is let in
+    void Resume(int i);			// Let entry "i" in
+    int NumRunning();			// Entries not waiting
+    void Estimate(bool force);		// Recompute totalWorkingSet, if
+					// it is stale or "force" is set
+    void ResumeWaiting();		// Let in waiting entries that fit
+};
+
+#endif // LOADCONTROL_H
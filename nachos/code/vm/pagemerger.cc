@@ -0,0 +1,234 @@
+// pagemerger.cc 
+//	Routines to find user pages with the same contents, and merge
+//	them into one frame.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "pagemerger.h"
+
+//----------------------------------------------------------------------
+// PageMergerThread
+// 	Body of the kernel thread that runs the merger: scan, then sleep
+//	for MergeScanInterval ticks, forever.  Nachos halts around it
+//	once the last user program exits.
+//----------------------------------------------------------------------
+
+static void
+PageMergerThread(int dummy)
+{
+    for (;;) {
+	sleepQueue->Sleep(MergeScanInterval);
+	pagingLock->Acquire();
+	pageMerger->Scan();
+	pagingLock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// PageMerger::PageMerger
+// 	Initialize the merger, with nothing merged.
+//
+//	"frameCount" is the number of physical page frames in mainMemory.
+//----------------------------------------------------------------------
+
+PageMerger::PageMerger(int frameCount)
+{
+    numFrames = frameCount;
+    for (numBuckets = 1; numBuckets < numFrames; numBuckets *= 2)
+	;
+    hashes = new unsigned int[numFrames];
+    next = new int[numFrames];
+    buckets = new int[numBuckets];
+    mergedInto = new BitMap(numFrames);
+}
+
+//----------------------------------------------------------------------
+// PageMerger::~PageMerger
+// 	De-allocate the merger.
+//----------------------------------------------------------------------
+
+PageMerger::~PageMerger()
+{
+    delete [] hashes;
+    delete [] next;
+    delete [] buckets;
+    delete mergedInto;
+}
+
+//----------------------------------------------------------------------
+// PageMerger::Start
+// 	Fork the kernel thread that scans for pages to merge.
+//----------------------------------------------------------------------
+
+void
+PageMerger::Start()
+{
+    NachOSThread *thread = new NachOSThread("page merger");
+
+    thread->ThreadFork(PageMergerThread, 0);
+}
+
+//----------------------------------------------------------------------
+// PageMerger::Scan
+// 	Go through the frames in use, hashing each one.  A frame whose
+//	contents match an earlier one is merged into it, or the other
+//	way round, if either of the two holds a private page that can
+//	be remapped.
+//
+//	The caller holds pagingLock, so no page changes under us.
+//----------------------------------------------------------------------
+
+void
+PageMerger::Scan()
+{
+    int frame, match, i;
+
+    for (i = 0; i < numBuckets; i++)
+	buckets[i] = -1;
+    for (frame = 0; frame < numFrames; frame++) {
+	if (frameAllocator->RefCount(frame) == 0)
+	    continue;			// free
+	hashes[frame] = Hash(frame);
+	match = FindMatch(frame, hashes[frame]);
+	if (match == -1)
+	    Insert(frame);
+	else if (IsPrivate(frame))
+	    Merge(frame, match);
+	else if (IsPrivate(match)) {
+	    Merge(match, frame);	// "frame" takes its place
+	    Remove(match);
+	    Insert(frame);
+	}
+    }
+    CountSaved();
+}
+
+//----------------------------------------------------------------------
+// PageMerger::IsPrivate
+// 	Return TRUE if "frame" holds a page of a single address space,
+//	known to the core map, which can therefore be remapped.
+//----------------------------------------------------------------------
+
+bool
+PageMerger::IsPrivate(int frame)
+{
+    return (coreMap->Owner(frame) != NULL)
+	&& (frameAllocator->RefCount(frame) == 1);
+}
+
+//----------------------------------------------------------------------
+// PageMerger::Insert, PageMerger::Remove
+// 	Add "frame" to, or take it out of, its hash chain.
+//----------------------------------------------------------------------
+
+void
+PageMerger::Insert(int frame)
+{
+    int bucket = hashes[frame] & (numBuckets - 1);
+
+    next[frame] = buckets[bucket];
+    buckets[bucket] = frame;
+}
+
+void
+PageMerger::Remove(int frame)
+{
+    int bucket = hashes[frame] & (numBuckets - 1);
+    int i;
+
+    if (buckets[bucket] == frame) {
+	buckets[bucket] = next[frame];
+	return;
+    }
+    for (i = buckets[bucket]; next[i] != frame; i = next[i])
+	;
+    next[i] = next[frame];
+}
+
+//----------------------------------------------------------------------
+// PageMerger::Hash
+// 	Return a hash of the contents of "frame" (FNV-1a).
+//----------------------------------------------------------------------
+
+unsigned int
+PageMerger::Hash(int frame)
+{
+    unsigned char *page =
+		(unsigned char *) &(machine->mainMemory[frame * PageSize]);
+    unsigned int hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < PageSize; i++)
+	hash = (hash ^ page[i]) * 16777619u;
+    return hash;
+}
+
+//----------------------------------------------------------------------
+// PageMerger::FindMatch
+// 	Return a frame already in the hash table whose contents are the
+//	same as those of "frame", whose hash is "hash", or -1 if there
+//	isn't one.
+//----------------------------------------------------------------------
+
+int
+PageMerger::FindMatch(int frame, unsigned int hash)
+{
+    int i;
+
+    for (i = buckets[hash & (numBuckets - 1)]; i != -1; i = next[i])
+	if ((hashes[i] == hash)
+		&& !bcmp(&(machine->mainMemory[i * PageSize]),
+			 &(machine->mainMemory[frame * PageSize]), PageSize))
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PageMerger::Merge
+// 	Remap the private page held in "frame" to "into", which has the
+//	same contents, freeing "frame".  If "into" holds a private page
+//	too, that page becomes copy-on-write first.
+//----------------------------------------------------------------------
+
+void
+PageMerger::Merge(int frame, int into)
+{
+    ProcessAddressSpace *owner = coreMap->Owner(frame);
+    int vpn = coreMap->VirtualPage(frame);
+
+    DEBUG('v', "Merging page %d from frame %d into frame %d\n", vpn, frame,
+	  into);
+    if (coreMap->Owner(into) != NULL)
+	coreMap->Owner(into)->ProtectPage(coreMap->VirtualPage(into));
+    owner->RemapPage(vpn, into);
+    mergedInto->Mark(into);
+    stats->numPagesMerged++;
+}
+
+//----------------------------------------------------------------------
+// PageMerger::CountSaved
+// 	Work out how many frames merging is saving now: every extra
+//	mapping of a frame that pages were merged into.  Frames no
+//	longer shared are forgotten.
+//----------------------------------------------------------------------
+
+void
+PageMerger::CountSaved()
+{
+    int frame, saved = 0;
+
+    for (frame = 0; frame < numFrames; frame++) {
+	if (!mergedInto->Test(frame))
+	    continue;
+	if (frameAllocator->RefCount(frame) <= 1)
+	    mergedInto->Clear(frame);
+	else
+	    saved += frameAllocator->RefCount(frame) - 1;
+    }
+    stats->numMergeFramesSaved = saved;
+    stats->peakMergeFramesSaved = max(stats->peakMergeFramesSaved, saved);
+}
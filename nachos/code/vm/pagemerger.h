@@ -0,0 +1,63 @@
+// pagemerger.h 
+//	Data structures for same-page merging: finding user pages with
+//	identical contents, and having them share one frame.
+//
+//	A kernel thread wakes up every MergeScanInterval ticks and hashes
+//	every frame in use.  When a page held privately by one address
+//	space turns out to match another frame, the page is remapped to
+//	that frame, copy-on-write, and its own frame is freed.  A write
+//	to it later takes a ReadOnlyException, and gets a copy of its own
+//	again, as for a page shared by Fork.
+//
+//	Any frame that is already shared can be merged into, since all
+//	its mappings are read-only: code pages, and pages shared by Fork
+//	or by earlier merges.  Only pages in the core map can be merged
+//	away, since their address space and virtual page are known there.
+//	A frame pages were merged into is evicted like any other, taking
+//	it away from all of them at once.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGEMERGER_H
+#define PAGEMERGER_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+#define MergeScanInterval	1000	// ticks between scans
+
+// The following class defines the page merger.  Each scan builds a
+// hash table of the frames seen so far, chained through "next".
+
+class PageMerger {
+  public:
+    PageMerger(int frameCount);		// Initialize, with nothing merged
+    ~PageMerger();			// De-allocate the merger
+
+    void Start();			// Fork the thread that scans
+    void Scan();			// Merge every page that can be;
+					// the caller holds pagingLock
+
+  private:
+    int numFrames;
+    int numBuckets;			// a power of two
+    unsigned int *hashes;		// hash of each frame's contents
+    int *buckets;			// first frame of each chain, or -1
+    int *next;				// next frame in the same chain
+    BitMap *mergedInto;			// frames that pages were merged into
+
+    unsigned int Hash(int frame);	// Hash the contents of "frame"
+    bool IsPrivate(int frame);		// Can its page be remapped?
+    void Insert(int frame);		// Add "frame" to its hash chain
+    void Remove(int frame);		// ... or take it out
+    int FindMatch(int frame, unsigned int hash);
+					// Earlier frame with the same
+					// contents, or -1
+    void Merge(int frame, int into);	// Remap the page in "frame" to
+					// "into"
+    void CountSaved();			// Update the frames saved
+};
+
+#endif // PAGEMERGER_H
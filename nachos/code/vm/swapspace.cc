@@ -0,0 +1,269 @@
+// swapspace.cc 
+//	Routines to manage the swap area.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "swapspace.h"
+#include "compress.h"
+
+//----------------------------------------------------------------------
+// SwapSpace::SwapSpace
+// 	Initialize the swap area, in turn initializing the disk it lives
+//	on.  Nothing in the swap area outlives Nachos, so every slot
+//	starts out free.
+//
+//	"name" -- UNIX file name to be used as storage for the swap area
+//	"poolBytes" -- size of the compressed page pool, or 0 to send
+//		every page to disk
+//----------------------------------------------------------------------
+
+SwapSpace::SwapSpace(char *name, int poolBytes)
+{
+    int i;
+
+    ASSERT(PageSize % SectorSize == 0);	// whole sectors per page
+    disk = new SynchDisk(name);
+    slotMap = new BitMap(NumSwapSlots);
+    slotRefs = new int[NumSwapSlots];
+    cacheBytes = poolBytes;
+    cacheUsed = 0;
+    cached = new char *[NumSwapSlots];
+    cachedSizes = new int[NumSwapSlots];
+    cachedOrder = new int[NumSwapSlots];
+    for (i = 0; i < NumSwapSlots; i++) {
+	slotRefs[i] = 0;
+	cached[i] = NULL;
+    }
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::~SwapSpace
+// 	De-allocate the swap area.
+//----------------------------------------------------------------------
+
+SwapSpace::~SwapSpace()
+{
+    int i;
+
+    for (i = 0; i < NumSwapSlots; i++)
+	delete [] cached[i];
+    delete [] cached;
+    delete [] cachedSizes;
+    delete [] cachedOrder;
+    delete slotMap;
+    delete [] slotRefs;
+    delete disk;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::AllocateSlot
+// 	Find a free slot and mark it in use, with one holder.
+//
+//	Returns the slot number, or -1 if swap is full.
+//----------------------------------------------------------------------
+
+int
+SwapSpace::AllocateSlot()
+{
+    int slot = slotMap->Find();
+
+    if (slot != -1)
+	slotRefs[slot] = 1;
+    DEBUG('v', "Allocated swap slot %d, %d slots left\n", slot,
+	  slotMap->NumClear());
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ShareSlot
+// 	Note one more holder of "slot": a page with the same contents,
+//	in another address space or the same one.  A shared slot is
+//	never written to; a holder that needs to save a different page
+//	lets go of it and allocates a slot of its own.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ShareSlot(int slot)
+{
+    ASSERT(slotMap->Test(slot));
+    slotRefs[slot]++;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::FreeSlot
+// 	One holder is done with "slot".  Once the last one is, return it
+//	to the pool of free slots, dropping its page from the compressed
+//	pool if it is there.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::FreeSlot(int slot)
+{
+    ASSERT(slotMap->Test(slot));
+    if (--slotRefs[slot] > 0)
+	return;
+    Uncache(slot);
+    slotMap->Clear(slot);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadPage, SwapSpace::WritePage
+// 	Move a page between swap "slot" and physical page "frame".
+//	Return only once the transfer is done.  Reads served from the
+//	compressed pool are counted as hits.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadPage(int slot, int frame)
+{
+    DEBUG('v', "Reading swap slot %d into frame %d%s\n", slot, frame,
+	  (cached[slot] != NULL) ? " from the pool" : "");
+    if (cacheBytes > 0) {
+	if (cached[slot] != NULL)
+	    stats->numSwapCacheHits++;
+	else
+	    stats->numSwapCacheMisses++;
+    }
+    ReadSlot(slot, &(machine->mainMemory[frame * PageSize]));
+}
+
+void
+SwapSpace::WritePage(int slot, int frame)
+{
+    DEBUG('v', "Writing frame %d to swap slot %d\n", frame, slot);
+    WriteSlot(slot, &(machine->mainMemory[frame * PageSize]));
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadSlot, SwapSpace::WriteSlot
+// 	Move a page between swap "slot" and the buffer "page": from the
+//	compressed pool if it is there, and otherwise from disk; to the
+//	pool if it will go there, and otherwise to disk.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadSlot(int slot, char *page)
+{
+    if (cached[slot] == NULL)
+	ReadSectors(slot, page);
+    else if (cachedSizes[slot] == PageSize)
+	bcopy(cached[slot], page, PageSize);
+    else
+	Decompress(cached[slot], cachedSizes[slot], page, PageSize);
+}
+
+void
+SwapSpace::WriteSlot(int slot, char *page)
+{
+    Uncache(slot);			// any older copy is stale
+    if ((cacheBytes == 0) || !CachePage(slot, page))
+	WriteSectors(slot, page);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadSectors, SwapSpace::WriteSectors
+// 	Move a page between swap "slot" on disk and the buffer "page".
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadSectors(int slot, char *page)
+{
+    int i;
+
+    for (i = 0; i < SectorsPerPage; i++)
+	disk->ReadSector(slot * SectorsPerPage + i, &page[i * SectorSize]);
+}
+
+void
+SwapSpace::WriteSectors(int slot, char *page)
+{
+    int i;
+
+    for (i = 0; i < SectorsPerPage; i++)
+	disk->WriteSector(slot * SectorsPerPage + i, &page[i * SectorSize]);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::CachePage
+// 	Compress "page" into the pool, as the contents of "slot".  A page
+//	that doesn't compress is kept as it is, which still saves the
+//	disk I/O.  If the pool is short of room, the pages that have
+//	been in it longest are written out to disk to make some.
+//
+//	Returns FALSE, having done nothing, if the page can't fit in the
+//	pool even when it is empty.
+//----------------------------------------------------------------------
+
+bool
+SwapSpace::CachePage(int slot, char *page)
+{
+    char *buffer = new char[CompressBound(PageSize)];
+    int size = Compress(page, PageSize, buffer);
+
+    if (size >= PageSize) {		// not worth decompressing
+	size = PageSize;
+	bcopy(page, buffer, PageSize);
+    }
+    if (size > cacheBytes) {
+	delete [] buffer;
+	return FALSE;
+    }
+    while (cacheUsed + size > cacheBytes)
+	SpillOldest();
+    cached[slot] = new char[size];
+    bcopy(buffer, cached[slot], size);
+    delete [] buffer;
+    cachedSizes[slot] = size;
+    cachedOrder[slot] = nextOrder++;
+    cacheUsed += size;
+    stats->numSwapCacheBytesIn += PageSize;
+    stats->numSwapCacheBytesStored += size;
+    DEBUG('v', "Swap slot %d compressed to %d bytes, pool %d of %d bytes\n",
+	  slot, size, cacheUsed, cacheBytes);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Uncache
+// 	Drop the page of "slot" from the pool, if it is there.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::Uncache(int slot)
+{
+    if (cached[slot] == NULL)
+	return;
+    cacheUsed -= cachedSizes[slot];
+    delete [] cached[slot];
+    cached[slot] = NULL;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::SpillOldest
+// 	Make room in the pool by writing the page that has been there
+//	longest out to its slot on disk.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::SpillOldest()
+{
+    char *page = new char[PageSize];
+    int slot, oldest = -1;
+
+    for (slot = 0; slot < NumSwapSlots; slot++)
+	if ((cached[slot] != NULL) && ((oldest == -1)
+		|| (cachedOrder[slot] < cachedOrder[oldest])))
+	    oldest = slot;
+    ASSERT(oldest != -1);
+    DEBUG('v', "Spilling swap slot %d from the pool to disk\n", oldest);
+    ReadSlot(oldest, page);
+    WriteSectors(oldest, page);
+    Uncache(oldest);
+    delete [] page;
+    stats->numSwapCacheSpills++;
+}
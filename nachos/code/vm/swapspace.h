@@ -0,0 +1,81 @@
+// swapspace.h 
+//	Data structures for the swap area, where pages evicted from
+//	physical memory are kept until they are needed again.
+//
+//	The swap area is a disk of its own (a UNIX file, "SWAP"), used
+//	through a SynchDisk.  A page is a whole number of sectors, so each
+//	swap slot is a run of SectorsPerPage sectors.
+//
+//	Optionally (-swapcache), pages written to swap are compressed and
+//	kept in a pool of kernel memory of bounded size instead, and only
+//	go to disk when the pool has no room for them; the pages that
+//	have been in the pool longest are written out to make room for
+//	new ones.  Reads of a slot whose page is still in the pool cost
+//	no disk I/O at all.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAPSPACE_H
+#define SWAPSPACE_H
+
+#include "copyright.h"
+#include "synchdisk.h"
+#include "bitmap.h"
+
+#define SectorsPerPage	(PageSize / SectorSize)
+#define NumSwapSlots	(NumSectors / SectorsPerPage)	// pages the swap
+							// area can hold
+
+// The following class defines the swap area.  Slots are handed out
+// from a BitMap, and counted like frames, since pages shared
+// copy-on-write can share a slot too; reads and writes go to the pool
+// or straight to the disk, and the calling thread waits until they
+// are done.
+
+class SwapSpace {
+  public:
+    SwapSpace(char *name, int poolBytes);
+					// Initialize the swap area, with
+					// every slot free, and a pool of
+					// "poolBytes" (0 for none)
+    ~SwapSpace();			// De-allocate the swap area
+
+    int AllocateSlot();			// Find a free slot, mark it in use
+					// and return it; -1 if swap is full
+    void ShareSlot(int slot);		// One more holder of "slot"
+    void FreeSlot(int slot);		// One less; the last one returns
+					// "slot" to the free pool
+    bool IsShared(int slot) { return slotRefs[slot] > 1; }
+					// Is "slot" held more than once?
+
+    void ReadPage(int slot, int frame);	// Read "slot" into physical "frame"
+    void WritePage(int slot, int frame);	// Write physical "frame" to
+					// "slot"
+    void ReadSlot(int slot, char *page);	// Read "slot" into "page"
+
+  private:
+    SynchDisk *disk;			// Where the slots live
+    BitMap *slotMap;			// One bit per slot, set if in use
+    int *slotRefs;			// Holders of each slot in use
+
+    int cacheBytes;			// Size of the pool
+    int cacheUsed;			// Bytes of it holding pages
+    char **cached;			// For each slot, its page in the
+					// pool, or NULL if it is on disk
+    int *cachedSizes;			// ... the compressed size of that
+					// page; PageSize if it is stored as is
+    int *cachedOrder;			// ... and when it went in
+    int nextOrder;			// Counter for cachedOrder
+
+    void WriteSlot(int slot, char *page);	// Write "page" to "slot"
+    void ReadSectors(int slot, char *page);	// The same, always on disk
+    void WriteSectors(int slot, char *page);
+    bool CachePage(int slot, char *page);	// Put "page" in the pool
+    void Uncache(int slot);			// Take "slot" out of the pool
+    void SpillOldest();			// Write the oldest page in the
+					// pool to disk
+};
+
+#endif // SWAPSPACE_H